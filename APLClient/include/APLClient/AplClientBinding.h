@@ -62,6 +62,14 @@ public:
      */
     Telemetry::DownloadMetricsEmitterPtr createDownloadMetricsEmitter(const std::string& metricsPrefix = "APLClientDownloadManager");
 
+    /**
+     * Enables the on-disk tier of the import package cache shared by the renderers of this binding, so that
+     * downloaded packages survive restarts.
+     *
+     * @param directory An existing, writable directory to store packages in, or an empty string to disable
+     */
+    void setPackageCacheDirectory(const std::string& directory);
+
     /**
      * Set an instance @c AplMetricsSinkInterface to the @c AplConfiguration
      *
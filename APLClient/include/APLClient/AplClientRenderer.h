@@ -61,6 +61,16 @@ public:
      */
     bool shouldHandleMessage(const std::string& message);
 
+    /**
+     * Pass an already parsed message received from the viewhost to the @c AplClientBinding, this should be called
+     * before @c handleMessage and on a different thread to @c renderDocument.
+     * @note The same parsed message should then be passed to @c handleMessage so that it is only parsed once
+     *
+     * @param message The parsed message from the viewhost
+     * @return true if the message should be passed onwards to handleMessage, false if handling is complete
+     */
+    bool shouldHandleMessage(const AplCoreViewhostInboundMessage& message);
+
     /**
      * Pass a message received from the viewhost to the @c AplClientBinding, should only be called if
      * @c shouldHandleMessage returns true and must be run on the same thread as @c renderDocument
@@ -68,6 +78,13 @@ public:
      */
     void handleMessage(const std::string& message);
 
+    /**
+     * Pass an already parsed message received from the viewhost to the @c AplClientBinding, should only be called if
+     * @c shouldHandleMessage returns true and must be run on the same thread as @c renderDocument
+     * @param message The parsed message from the viewhost
+     */
+    void handleMessage(const AplCoreViewhostInboundMessage& message);
+
     /**
      * Render an APL document
      * @param document The document json payload
@@ -81,6 +98,44 @@ public:
         const std::string& viewports,
         const std::string& token);
 
+    /**
+     * Render an already parsed APL document, taking ownership of the parsed JSON
+     * @param document The parsed document json payload
+     * @param data The parsed document data, which must own its JSON
+     * @param viewports The supported viewports
+     * @param token The APL document token
+     */
+    void renderDocument(
+        apl::JsonData&& document,
+        apl::JsonData&& data,
+        const std::string& viewports,
+        const std::string& token);
+
+    /**
+     * Prepare an APL document in the background, ahead of rendering it. The document is parsed, its data bound and
+     * its imports downloaded, so that a later @c renderDocument with the same document and data goes straight to
+     * inflation.
+     * @param document The document json payload
+     * @param data The document data
+     */
+    void prefetchDocument(const std::string& document, const std::string& data);
+
+    /**
+     * Keep inflated documents so that rendering one again with the same document, data and viewports restores it
+     * instead of inflating it again. A restored document resumes in the state it was left in, as with backstack
+     * navigation. Documents which request extensions and parsed documents are never cached.
+     * @param maxEntries The maximum number of documents kept, 0 (the default) disables the cache
+     */
+    void setDocumentCacheSize(size_t maxEntries);
+
+    /**
+     * Enable data-only renders: rendering the displayed document again with new data, within the same skill, updates
+     * the changed values in place and sends only the affected components to the viewhost. Datasources are bound as
+     * live data for this, and documents whose arrays change are still rendered anew.
+     * @param enabled Whether data-only renders are enabled, off by default
+     */
+    void setDataOnlyRenderEnabled(bool enabled);
+
     /**
      * Set a default viewhost config to use when initialzing the document. If not provided or it is different 
      * from the one provided to the browser side, it will be replaced by the browser side one during inflation.
@@ -125,6 +180,13 @@ public:
      */
     void onUpdateTick();
 
+    /**
+     * Returns the earliest time at which @c onUpdateTick has work to do, so that hosts can sleep between ticks
+     * instead of polling at the display refresh rate. Static documents report @c time_point::max().
+     * @note Query again after calling into the renderer, as that may schedule work.
+     */
+    std::chrono::steady_clock::time_point getNextTickTime();
+
     /**
      * Returns the target window Id for this renderer
      */
@@ -186,6 +248,12 @@ public:
      */
     void handleDisplayMetrics(const std::string& message);
 
+    /**
+     * Handle the parsed displayMetrics message received from the sandbox
+     * @param message
+     */
+    void handleDisplayMetrics(const AplCoreViewhostInboundMessage& message);
+
 
     /// @name AplRenderingEventObserver Functions
     /// @{
@@ -207,7 +275,7 @@ private:
     AplConfigurationPtr m_aplConfiguration;
 
     /// View host message type to handler map interceptors
-    std::map<std::string, std::function<void(const std::string&)>> m_messageHandlers;
+    std::map<std::string, std::function<void(const AplCoreViewhostInboundMessage&)>> m_messageHandlers;
 
     std::string m_windowId;
 
@@ -221,6 +289,13 @@ private:
 
     std::unique_ptr<Telemetry::AplTimerHandle> m_renderTimer;
 
+    /**
+     * Adds the token, client and skill of a document being rendered to its metrics
+     *
+     * @param token The APL document token
+     */
+    void addDocumentMetadata(const std::string& token);
+
     /**
      * Validates the content from the metrics payload
      * 
@@ -228,6 +303,13 @@ private:
      * @return bool Indicates whether the metric content is valid
      */
     bool validateJsonMetric(const rapidjson::Value& jsonMetric);
+
+    /**
+     * Records the metrics from a parsed metrics payload
+     *
+     * @param metricsPayload The array of metrics reported by the viewhost
+     */
+    void reportMetrics(const rapidjson::Value& metricsPayload);
 };
 
 using AplClientRendererPtr = std::shared_ptr<AplClientRenderer>;
@@ -18,6 +18,8 @@
 
 #include <memory>
 
+#include "AplCorePackageCache.h"
+#include "AplCoreTextMeasureCache.h"
 #include "AplOptionsInterface.h"
 #include "Telemetry/AplMetricsRecorderInterface.h"
 
@@ -57,9 +59,25 @@ public:
      */
     void setMetricsRecorder(Telemetry::AplMetricsRecorderInterfacePtr metricsRecorder);
 
+    /**
+     * Returns the text measurement cache shared by every renderer using this configuration. This is never null.
+     *
+     * @return the shared text measurement cache
+     */
+    AplCoreTextMeasureCachePtr getTextMeasureCache() const;
+
+    /**
+     * Returns the import package cache shared by every renderer using this configuration. This is never null.
+     *
+     * @return the shared package cache
+     */
+    AplCorePackageCachePtr getPackageCache() const;
+
 private:
     AplOptionsInterfacePtr m_aplOptions;
     Telemetry::AplMetricsRecorderInterfacePtr m_metricsRecorder;
+    AplCoreTextMeasureCachePtr m_textMeasureCache;
+    AplCorePackageCachePtr m_packageCache;
 };
 
 /// Convenience typedef
@@ -97,6 +97,13 @@ public:
      */
     void tick(const AplCoreConnectionManager& connectionManager);
 
+    /**
+     * @return true if the player is playing
+     */
+    bool isPlaying() const {
+        return m_Playing;
+    }
+
 private:
     void sendAudioPlayerCommand(const std::string& command, std::string optionalUrl = "");
     void resolveExistingAction();
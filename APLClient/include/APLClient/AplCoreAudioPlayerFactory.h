@@ -63,6 +63,11 @@ public:
 
     void tick(const AplCoreConnectionManager& connectionManager);
 
+    /**
+     * @return true if any player is playing and so needs to be ticked
+     */
+    bool hasPlayingPlayers() const;
+
     /// @name apl::AudioPlayerFactory Functions
     /// @{
     apl::AudioPlayerPtr createPlayer(apl::AudioPlayerCallback playerCallback,
@@ -16,9 +16,17 @@
 #ifndef APL_CLIENT_LIBRARY_APL_CORE_CONNECTION_MANAGER_H_
 #define APL_CLIENT_LIBRARY_APL_CORE_CONNECTION_MANAGER_H_
 
+#include <atomic>
+#include <deque>
+#include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <future>
+#include <mutex>
+#include <thread>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wreorder"
 #pragma push_macro("DEBUG")
@@ -36,7 +44,12 @@
 #include <alexaext/alexaext.h>
 
 #include "AplConfiguration.h"
+#include "AplCoreDocumentCache.h"
+#include "AplCoreHierarchyDiff.h"
+#include "AplCoreInputCoalescer.h"
 #include "AplCoreViewhostMessage.h"
+#include "AplCoreViewhostInboundMessage.h"
+#include "AplCoreViewhostRequestChannel.h"
 #include "AplCoreMetrics.h"
 #include "AplViewhostConfig.h"
 #include "Extensions/AplCoreExtensionEventCallbackResultInterface.h"
@@ -54,6 +67,8 @@ using namespace APLClient::Extensions;
 
 class AplCoreAudioPlayerFactory;
 class AplCoreMediaPlayerFactory;
+class AplCorePackageDownloader;
+class AplCoreTextMeasurement;
 
 /**
  * Interacts with the APL Core Engine handling the event loop, updates etc. and passes messages between the core
@@ -64,6 +79,9 @@ class AplCoreConnectionManager
         , public AplCoreExtensionEventCallbackResultInterface
         , public std::enable_shared_from_this<AplCoreConnectionManager> {
 public:
+    /// Live data objects by the name they are bound to in documents
+    using LiveDataMap = std::unordered_map<std::string, apl::LiveObjectPtr>;
+
     AplCoreConnectionManager(AplConfigurationPtr config);
 
     virtual ~AplCoreConnectionManager() = default;
@@ -112,12 +130,26 @@ public:
      */
     bool shouldHandleMessage(const std::string& message);
 
+    /**
+     * Receives an already parsed message from the APL view host and identifies if it will require further handling
+     * @note This function does not need to be handled on the same execution thread as other function calls
+     * @param message The parsed message
+     * @return true if the message should be passed to @c handleMessage, false if message
+     */
+    bool shouldHandleMessage(const AplCoreViewhostInboundMessage& message);
+
     /**
      * Receives messages from the APL view host
      * @param message The JSON Payload
      */
     void handleMessage(const std::string& message);
 
+    /**
+     * Receives an already parsed message from the APL view host
+     * @param message The parsed message
+     */
+    void handleMessage(const AplCoreViewhostInboundMessage& message);
+
     /**
      * Executes an APL command
      * @param command The command to execute
@@ -154,12 +186,44 @@ public:
         AplCoreViewhostMessage& message,
         const std::chrono::milliseconds& timeout = std::chrono::milliseconds(2000));
 
+    /**
+     * Send a request to the view host without waiting for the reply. Any number of requests may be outstanding at
+     * once, so independent requests can be issued back to back and their replies awaited together.
+     * @param message The message to send
+     * @param timeout The time after which the request is considered failed
+     * @return A future holding the reply, which is an invalid message if a response was not received in time.
+     */
+    std::future<AplCoreViewhostInboundMessage> sendRequest(
+        AplCoreViewhostMessage& message,
+        const std::chrono::milliseconds& timeout = std::chrono::milliseconds(2000));
+
+    /**
+     * Send a request to the view host and invoke @c callback with the reply.
+     * @note The callback runs on the thread which calls @c shouldHandleMessage, or on the thread which calls
+     * @c onUpdateTick if the request times out.
+     * @param message The message to send
+     * @param callback The callback to invoke with the reply, or an invalid message if a response was not received
+     * @param timeout The time after which the request is considered failed
+     * @return The sequence number of this message
+     */
+    unsigned int sendRequest(
+        AplCoreViewhostMessage& message,
+        AplCoreViewhostRequestChannel::ReplyCallback callback,
+        const std::chrono::milliseconds& timeout = std::chrono::milliseconds(2000));
+
     void provideState(unsigned int stateRequestToken);
 
     AplCoreMetricsPtr aplCoreMetrics() const {
         return m_AplCoreMetrics;
     }
 
+    /**
+     * @return The arena to build frequently sent messages in
+     */
+    AplCoreViewhostMessageArena& messageArena() {
+        return m_messageArena;
+    }
+
     /**
      * Schedules an update on the root context and runs the update loop - this may result in the viewhost being
      * updated and any events currently pending will be processed. If nothing is currently being displayed calling
@@ -168,6 +232,18 @@ public:
      */
     void onUpdateTick();
 
+    /**
+     * Returns the earliest time at which @c onUpdateTick has work to do. This is now while core has events or dirty
+     * components to process, a message was handled since the last tick, or audio is playing. Otherwise it is the
+     * next core timer, which covers running commands and animations, or the deadline of an outstanding viewhost
+     * request. With nothing pending it is @c time_point::max(), and the host may sleep until a message arrives.
+     *
+     * @note The result is only valid until the next call into the connection manager, so it should be queried again
+     * after handling a message or any other API call.
+     * @return The time of the next required tick
+     */
+    std::chrono::steady_clock::time_point getNextTickTime();
+
     /**
      * Resets the connection manager to remove the current document
      */
@@ -234,6 +310,48 @@ public:
      */
     void restoreDocumentState(AplDocumentStatePtr documentState);
 
+    /**
+     * Sets how many inflated documents are kept to be restored when rendered again, see @c AplCoreDocumentCache
+     * @param maxEntries The maximum number of documents kept, 0 (the default) disables the cache
+     */
+    void setDocumentCacheSize(size_t maxEntries);
+
+    /**
+     * @return true if inflated documents are kept in the document cache
+     */
+    bool isDocumentCacheEnabled() const {
+        return m_documentCache.isEnabled();
+    }
+
+    /**
+     * Restores a document inflated earlier from the same document, data and viewports for the current viewhost
+     * configuration.
+     * @param documentKey The document cache key, see @c AplCoreDocumentCache::makeDocumentKey
+     * @param token APL Presentation token for this render
+     * @return true if a cached document is being restored, and no content needs to be created
+     */
+    bool restoreCachedDocument(const AplCoreDocumentCache::Key& documentKey, const std::string& token);
+
+    /**
+     * Sets how the content passed to the next @c setContent is inflated and cached.
+     * @param documentKey The document cache key to cache the content under once inflated, empty to not cache it
+     * @param liveData Live data objects to register with the root config the content is inflated with
+     */
+    void prepareContent(const AplCoreDocumentCache::Key& documentKey, LiveDataMap liveData);
+
+    /**
+     * @param content The content to check
+     * @return true if the given content is currently displayed, and no other document is about to replace it
+     */
+    bool isDisplaying(const apl::ContentPtr& content) const;
+
+    /**
+     * Completes a render which updated the live data of the displayed document instead of inflating a new one. The
+     * affected components are sent to the viewhost as dirty updates on the next tick.
+     * @param token APL Presentation token for this render
+     */
+    void onLiveDataUpdated(const std::string& token);
+
     // Initialise Extensions provided via the AlexaExt flow (alexaext::Extension)
     bool initAlexaExts(const std::set<std::string>& requestedExtensions);
 
@@ -284,6 +402,22 @@ private:
      */
     void sendViewhostScalingMessage();
 
+    /**
+     * Lays the content out once without inflating it for display, collecting the text measurements it requires and
+     * sending them to the viewhost as one @c measureBatch message. The replies prime the text measurement cache so the
+     * real inflation does not pay one round trip per text component.
+     *
+     * The dry run answers each request it records with an estimate, so text laid out against an estimated size may
+     * still be measured on its own by the real inflation.
+     */
+    void premeasureText();
+
+    /**
+     * @return The hash of the current document and build environment which identifies it in
+     * @c m_premeasuredDocuments, or 0 if the document is not known
+     */
+    uint64_t getPremeasureHash() const;
+
     /**
      * Sends document background information to the client
      * @param background
@@ -469,6 +603,25 @@ private:
      */
     void handleReHierarchy(const rapidjson::Value& payload);
 
+    /**
+     * Handle the materialize message received from ViewHost, which asks for placeholders to be sent in full.
+     * @param payload
+     */
+    void handleMaterialize(const rapidjson::Value& payload);
+
+    /**
+     * @param type The type of an inbound message
+     * @param payload The payload of the message
+     * @return The state the message sets if it is applied at the next frame and superseded by a later message with
+     * the same key, or empty if it is handled at once
+     */
+    static std::string getCoalescingKey(const std::string& type, const rapidjson::Value& payload);
+
+    /**
+     * Applies the queued inbound messages in order
+     */
+    void applyCoalescedInput();
+
     /**
      * Execute the event.
      * ActionRefs have to be stored while we are waiting for a response.
@@ -486,10 +639,141 @@ private:
      */
     bool addPendingEvent(unsigned int token, const apl::Event& event, bool isViewhostEvent = true);
 
-    void sendHierarchy(const std::string& messageKey, bool blocking = false);
+    /**
+     * Sends the component hierarchy of the current document
+     * @param messageKey The message type
+     * @param blocking Whether to wait for the viewhost to respond
+     * @param allowDiff Whether the hierarchy may be sent as a diff against the last one, if the viewhost supports it
+     */
+    void sendHierarchy(const std::string& messageKey, bool blocking = false, bool allowDiff = false);
 
+    /**
+     * Replaces the content and asks the viewhost to reset, which rebuilds the document with a new root context
+     * @param content The content to render
+     * @param token APL Presentation token for this content
+     * @param documentKey The document cache key of the content, empty if it is not cached
+     * @param liveData Live data objects to inflate the content with
+     */
+    void resetContent(
+        const apl::ContentPtr& content,
+        const std::string& token,
+        const AplCoreDocumentCache::Key& documentKey,
+        LiveDataMap liveData);
+
+    /**
+     * @param content The content to render
+     * @return true if the content can be inflated in the background while the current document stays live
+     */
+    bool canStageContent(const apl::ContentPtr& content) const;
+
+    /**
+     * Starts inflating a document off the render thread. The current root keeps ticking and handling input until the
+     * staged root is swapped in by @c swapStagedDocument.
+     * @param content The content to render, which must be ready
+     * @param token APL Presentation token for this content
+     * @param documentKey The document cache key of the content, empty if it is not cached
+     * @param liveData Live data objects to inflate the content with
+     */
+    void stageContent(
+        const apl::ContentPtr& content,
+        const std::string& token,
+        const AplCoreDocumentCache::Key& documentKey,
+        LiveDataMap liveData);
+
+    /**
+     * Replaces the current document with the staged one and sends its hierarchy, if its inflation has completed
+     */
+    void swapStagedDocument();
+
+    /**
+     * Adds the current document to the document cache, if it has a document key and can be restored
+     */
+    void cacheDocument();
+
+    /**
+     * Builds the displayed children of a component and its descendants, by unique id, for the components whose
+     * displayed children differ from those last sent to the viewhost, and records them as sent. Only the children
+     * which were not displayed before are descended into, so the cost follows the change rather than the subtree.
+     * @param component The component to start from
+     * @param message The message to allocate in
+     * @return The displayed children by unique id
+     */
     rapidjson::Value buildDisplayedChildrenHierarchy(const apl::ComponentPtr& component, AplCoreViewhostMessage& message);
 
+    /**
+     * Forgets the displayed children sent for a removed component and its descendants
+     * @param uniqueId The unique id of the removed component
+     */
+    void forgetDisplayedChildren(const std::string& uniqueId);
+
+    /**
+     * Serializes a component with its subtree for the viewhost. When the viewhost supports a virtualized hierarchy,
+     * the children of Sequence, GridSequence and Pager components outside the viewport and its margin, and the pages
+     * other than the current one, are sent as placeholders with their bounds.
+     * @param component The component to serialize
+     * @param allocator The allocator of the message
+     * @return The serialized component
+     */
+    rapidjson::Value serializeComponent(const apl::ComponentPtr& component, rapidjson::Document::AllocatorType& allocator);
+
+    /**
+     * Replaces the virtualized children of a serialized subtree which are out of view by placeholders
+     * @param component The component
+     * @param serialized The serialized component, updated in place
+     * @param viewport The viewport with its margin, in global coordinates
+     * @param allocator The allocator of the message
+     */
+    void virtualize(
+        const apl::ComponentPtr& component,
+        rapidjson::Value& serialized,
+        const apl::Rect& viewport,
+        rapidjson::Document::AllocatorType& allocator);
+
+    /**
+     * @param component The component
+     * @return true if an ancestor of the component was sent as a placeholder
+     */
+    bool isInsidePlaceholder(const apl::ComponentPtr& component);
+
+    /**
+     * Sends the given placeholders in full in a materialize message, ignoring those which are not placeholders
+     * @param uniqueIds The unique ids of the placeholders
+     */
+    void sendMaterialized(const std::vector<std::string>& uniqueIds);
+
+    /**
+     * Materializes the current or next page of a virtualized pager, one page per call
+     */
+    void prefetchPagerPages();
+
+    /**
+     * @param component The component
+     * @return true if the component is displayed within its parent, not considering its ancestors
+     */
+    bool isDisplayed(const apl::ComponentPtr& component);
+
+    /**
+     * @param component The component
+     * @return true if the component and all of its ancestors are displayed within their parents
+     */
+    bool isShown(const apl::ComponentPtr& component);
+
+    /**
+     * Holds the dirty properties of a component the viewhost does not show, such as one scrolled out of view, on a
+     * page not shown or below a component which is not displayed. Structural changes, and the changes through which a
+     * component may hide itself, are not held.
+     * @param component The dirty component
+     * @return true if the update is held
+     */
+    bool deferDirty(const apl::ComponentPtr& component);
+
+    /**
+     * Adds the held properties of the components which are now displayed to the updates of this frame
+     * @param updates The updates by unique id
+     * @param message The dirty message
+     */
+    void flushDeferredDirty(std::map<std::string, rapidjson::Value>& updates, AplCoreViewhostMessage& message);
+
     /**
      * Process set of dirty components and send out dirty properties as required.
      * @param dirty dirty components set.
@@ -513,6 +797,46 @@ private:
      */
     void sendError(const std::string& message);
 
+    /**
+     * Queues a message for the view host with an already allocated sequence number. @c m_frameBatchMutex must be held
+     * from the allocation of the sequence number, so that messages are queued in sequence number order. Queued
+     * messages are handed to the host by @c sendOutbound.
+     * @param message The message to send
+     * @param seqno The sequence number of the message
+     * @param immediate Whether to send the message now, after any messages batched so far, rather than batching it.
+     * Requests awaiting a reply are sent immediately.
+     */
+    void sendWithSequenceNumber(AplCoreViewhostMessage& message, unsigned int seqno, bool immediate = false);
+
+    /**
+     * Hands the queued messages to the host in order. Must be called without @c m_frameBatchMutex held, so that the
+     * host may send or answer requests from within @c sendMessage. If another thread is handing messages over, it
+     * also hands over those queued by this one.
+     */
+    void sendOutbound();
+
+    /**
+     * Starts gathering sent messages into a frame batch.
+     * @return false if a batch is already being gathered or the viewhost does not support frame batches
+     */
+    bool beginFrameBatch();
+
+    /**
+     * Sends the messages gathered so far. A single message is sent as is, several are wrapped in one envelope, in
+     * the order they were sent:
+     *
+     *     { "type": "frameBatch",
+     *       "payload": [ MESSAGE, ... ] }
+     *
+     * @param endBatch Whether to stop batching, otherwise the batch stays open
+     */
+    void flushFrameBatch(bool endBatch = false);
+
+    /**
+     * Queues the messages gathered so far, as @c flushFrameBatch does. @c m_frameBatchMutex must be held.
+     */
+    void sendFrameBatch();
+
     /**
      * Get optional value from Json.
      * @param jsonNode json data
@@ -635,19 +959,62 @@ private:
     bool m_ScreenLock;
 
     /// Next packet sequence number
-    unsigned int m_SequenceNumber;
+    std::atomic<unsigned int> m_SequenceNumber;
+
+    /// The requests sent to the viewhost which are awaiting a reply
+    AplCoreViewhostRequestChannel m_requestChannel;
+
+    /// Whether the viewhost supports batched text measurement
+    bool m_measureBatchSupported;
+
+    /// The mutex protecting the creation of the package downloader, packages are loaded from several threads
+    std::mutex m_packageDownloaderMutex;
+
+    /// The worker pool downloading the packages of every load, created on the first download
+    std::shared_ptr<AplCorePackageDownloader> m_packageDownloader;
+
+    /// The text measurement of the root config of the last build
+    std::shared_ptr<AplCoreTextMeasurement> m_textMeasurement;
 
-    /// The sequence number which a blockingSend is waiting for
-    unsigned int m_replyExpectedSequenceNumber;
+    /// The documents whose last inflation measured all of their text from the cache, which are inflated again without
+    /// a premeasure dry run, see @c getPremeasureHash
+    std::unordered_set<uint64_t> m_premeasuredDocuments;
 
-    /// Whether we are expecting a reply to a blockingSend
-    bool m_blockingSendReplyExpected;
+    /// Whether the viewhost supports frame batches
+    bool m_frameBatchSupported;
 
-    /// The pending promise from a call to blockingSend
-    std::promise<std::string> m_replyPromise;
+    /// The mutex protecting the frame batch and the outbound queue, held from the allocation of a sequence number
+    /// until its message is queued
+    std::mutex m_frameBatchMutex;
 
-    /// The mutex protecting blockingSend
-    std::mutex m_blockingSendMutex;
+    /// A message waiting to be handed to the host
+    struct OutboundMessage {
+        std::string token;
+        std::string message;
+        /// Whether the message is handed over with @c transferMessage
+        bool transfer;
+    };
+
+    /// The messages waiting to be handed to the host, in sequence number order
+    std::deque<OutboundMessage> m_outbound;
+
+    /// The thread handing the queued messages to the host, if any
+    std::thread::id m_outboundSender;
+
+    /// Whether sent messages are being gathered into a frame batch
+    bool m_frameBatching;
+
+    /// The serialized messages of the frame batch, separated by commas
+    std::string m_frameBatch;
+
+    /// The number of messages in @c m_frameBatch
+    size_t m_frameBatchSize;
+
+    /// The arena the messages sent every frame are built in
+    AplCoreViewhostMessageArena m_messageArena;
+
+    /// Whether a message was handled since the last tick
+    std::atomic_bool m_tickRequested;
 
     /// Pointer to ExtensionManager
     AplCoreExtensionManagerPtr m_extensionManager;
@@ -664,6 +1031,99 @@ private:
     std::shared_ptr<AplCoreAudioPlayerFactory> m_audioPlayerFactory;
 
     std::shared_ptr<AplCoreMediaPlayerFactory> m_mediaPlayerFactory;
+
+    /// A document prepared and inflated off the render thread to replace the current one
+    struct StagedDocument {
+        /// Tells the preparation to stop, the document is no longer needed
+        ~StagedDocument() {
+            *cancelled = true;
+        }
+
+        apl::ContentPtr content;
+        std::string token;
+        AplCoreDocumentCache::Key documentKey;
+        LiveDataMap liveData;
+        apl::RootConfig rootConfig;
+        AplCoreMetricsPtr metrics;
+        std::shared_ptr<AplCoreAudioPlayerFactory> audioPlayerFactory;
+        std::shared_ptr<AplCoreMediaPlayerFactory> mediaPlayerFactory;
+        std::shared_ptr<AplCoreTextMeasurement> textMeasurement;
+        std::chrono::milliseconds startTime;
+        /// The inflated root, or null if the content could not be prepared or inflated
+        std::future<apl::RootContextPtr> root;
+        std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+    };
+
+    /// Whether the viewhost accepts a new hierarchy for a different document without being reset
+    bool m_documentSwapSupported;
+
+    /// The root config of the last build before any extension registration, used to inflate staged documents
+    std::unique_ptr<apl::RootConfig> m_stagingRootConfig;
+
+    /// The document being inflated to replace the current one, if any
+    std::unique_ptr<StagedDocument> m_stagedDocument;
+
+    /// Inflated documents to restore when rendered again
+    AplCoreDocumentCache m_documentCache;
+
+    /// The document cache key of the content passed to the next @c setContent
+    AplCoreDocumentCache::Key m_nextDocumentKey;
+
+    /// The live data of the content passed to the next @c setContent
+    LiveDataMap m_nextLiveData;
+
+    /// The live data registered with the root config of the current content
+    LiveDataMap m_liveData;
+
+    /// The document cache key of the current content, empty if it is not cached
+    AplCoreDocumentCache::Key m_documentKey;
+
+    /// The metrics and root config options of the last build, which complete the document cache key
+    std::string m_buildEnvironment;
+
+    /// Whether @c m_documentStateToRestore came from the document cache
+    bool m_restoringCachedDocument;
+
+    /// The displayed children last sent to the viewhost, by component unique id
+    std::unordered_map<std::string, std::vector<std::string>> m_displayedChildren;
+
+    /// Whether the viewhost can apply a hierarchy diff to its existing components
+    bool m_hierarchyDiffSupported;
+
+    /// The fingerprint of the last hierarchy sent, when the viewhost supports hierarchy diffs
+    AplCoreHierarchyDiff m_hierarchyDiff;
+
+    /// Whether the viewhost accepts placeholders for the out of view children of Sequence, GridSequence and Pager
+    bool m_virtualizedHierarchySupported;
+
+    /// The margin around the viewport in dp within which virtualized children are sent in full, negative for one
+    /// viewport
+    double m_virtualizationMargin;
+
+    /// The unique ids of the components the viewhost has as placeholders
+    std::unordered_set<std::string> m_placeholders;
+
+    /// The unique ids of the pagers with pages sent as placeholders
+    std::unordered_set<std::string> m_virtualizedPagers;
+
+    /// The dirty properties held for a component the viewhost does not show
+    struct DeferredDirty {
+        std::weak_ptr<apl::Component> component;
+        std::set<apl::PropertyKey> properties;
+    };
+
+    /// The held dirty properties by component unique id, sent with their latest value once the component is shown
+    std::unordered_map<std::string, DeferredDirty> m_deferredDirty;
+
+    /// The unique ids of the displayed children of each parent looked up while processing the dirty components of a
+    /// frame, by parent unique id
+    std::unordered_map<std::string, std::unordered_set<std::string>> m_frameDisplayedChildren;
+
+    /// Whether each component looked up while processing the dirty components of a frame is shown, by unique id
+    std::unordered_map<std::string, bool> m_frameShown;
+
+    /// The pointer moves, scroll positions and media states received since the last frame
+    AplCoreInputCoalescer m_inputCoalescer;
 };
 
 using AplCoreConnectionManagerPtr = std::shared_ptr<AplCoreConnectionManager>;
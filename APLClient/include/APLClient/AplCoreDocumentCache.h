@@ -0,0 +1,190 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APL_CLIENT_LIBRARY_APL_CORE_DOCUMENT_CACHE_H_
+#define APL_CLIENT_LIBRARY_APL_CORE_DOCUMENT_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Extensions/AplDocumentState.h"
+
+namespace APLClient {
+
+/**
+ * A cache of inflated documents, so that a document rendered again with the same data, viewports and viewhost
+ * configuration is restored like a backstack @c AplDocumentState instead of being created and inflated again.
+ *
+ * A restored document resumes in the state it was left in. The cache holds a bounded number of documents, evicting
+ * the least recently used, and is disabled when that number is 0. It belongs to one renderer and is not thread safe.
+ */
+class AplCoreDocumentCache {
+public:
+    /**
+     * What a document is rendered from. Documents are indexed by the hash of their inputs, and the inputs are kept once
+     * per document and shared by the copies of its key, so that a hash collision is told apart on a hit.
+     */
+    struct Key {
+        /// The hash of @c inputs
+        uint64_t hash = 0;
+
+        /// The document, data and viewports, null for a document which is not cached but only told apart by its hash
+        std::shared_ptr<const std::string> inputs;
+
+        /**
+         * @return true if the key does not identify a document
+         */
+        bool empty() const {
+            return !inputs;
+        }
+
+        /**
+         * Resets the key so that it does not identify a document.
+         */
+        void clear() {
+            hash = 0;
+            inputs.reset();
+        }
+
+        bool operator==(const Key& other) const {
+            return hash == other.hash && (inputs == other.inputs || (inputs && other.inputs && *inputs == *other.inputs));
+        }
+
+        bool operator!=(const Key& other) const {
+            return !(*this == other);
+        }
+    };
+
+    /**
+     * Constructor
+     * @param maxEntries The maximum number of documents held before the least recently used is evicted
+     */
+    explicit AplCoreDocumentCache(size_t maxEntries = 0);
+
+    /**
+     * Combines what a document is rendered from into a key.
+     * @param document The document json payload
+     * @param data The document data
+     * @param supportedViewports The supported viewports
+     * @return The document key
+     */
+    static Key makeDocumentKey(const std::string& document, const std::string& data, const std::string& supportedViewports);
+
+    /**
+     * Hashes what a document is rendered from without keeping it, for a document which is not cached. The hash is the
+     * one @c makeDocumentKey computes for the same inputs.
+     * @param document The document json payload
+     * @param data The document data
+     * @param supportedViewports The supported viewports
+     * @return The document key, which is empty but holds the hash
+     */
+    static Key makeUncachedDocumentKey(
+        const std::string& document,
+        const std::string& data,
+        const std::string& supportedViewports);
+
+    /**
+     * Sets the maximum number of documents held, evicting the least recently used beyond it.
+     * @param maxEntries The maximum number of documents, 0 disables the cache
+     */
+    void setMaxEntries(size_t maxEntries);
+
+    /**
+     * @return true if the cache holds documents
+     */
+    bool isEnabled() const {
+        return m_maxEntries > 0;
+    }
+
+    /**
+     * Looks up a document, marking it as most recently used.
+     * @param key The document key
+     * @param environment The metrics and root config the document is inflated with, in any stable serialized form
+     * @return The cached document state, or nullptr if not found
+     */
+    Extensions::AplDocumentStatePtr get(const Key& key, const std::string& environment);
+
+    /**
+     * Stores a document, replacing any held for the same key and environment.
+     * @param key The document key
+     * @param environment The metrics and root config the document is inflated with
+     * @param documentState The inflated document
+     */
+    void put(const Key& key, const std::string& environment, Extensions::AplDocumentStatePtr documentState);
+
+    /**
+     * Removes a document, as when its root no longer matches its key.
+     * @param key The document key
+     * @param environment The metrics and root config the document was inflated with
+     */
+    void erase(const Key& key, const std::string& environment);
+
+    /**
+     * Removes every document.
+     */
+    void clear();
+
+    /**
+     * @return The number of documents held
+     */
+    size_t size() const {
+        return m_entries.size();
+    }
+
+private:
+    /// A cached document and what it was inflated from
+    struct Entry {
+        Key key;
+        std::string environment;
+        Extensions::AplDocumentStatePtr documentState;
+    };
+
+    using LruList = std::list<Entry>;
+
+    /**
+     * @param key The document key
+     * @param environment The metrics and root config the document is inflated with
+     * @return The hash a document is indexed by
+     */
+    static uint64_t indexHash(const Key& key, const std::string& environment);
+
+    /**
+     * @param key The document key
+     * @param environment The metrics and root config the document is inflated with
+     * @return The index entry of the document, or the end of the index if it is not held
+     */
+    std::unordered_map<uint64_t, LruList::iterator>::iterator find(const Key& key, const std::string& environment);
+
+    /**
+     * Evicts the least recently used documents beyond the maximum
+     */
+    void trim();
+
+    /// The maximum number of documents held
+    size_t m_maxEntries;
+
+    /// The documents held, most recently used first
+    LruList m_entries;
+
+    /// Index of @c m_entries by the hash of their key and environment, a collision holds only the latest document
+    std::unordered_map<uint64_t, LruList::iterator> m_index;
+};
+
+}  // namespace APLClient
+
+#endif  // APL_CLIENT_LIBRARY_APL_CORE_DOCUMENT_CACHE_H_
@@ -30,7 +30,14 @@
 #pragma pop_macro("FALSE")
 #pragma GCC diagnostic pop
 
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 #include "AplConfiguration.h"
 #include "AplCoreConnectionManager.h"
@@ -46,10 +53,17 @@ class AplCoreGuiRenderer {
 public:
     AplCoreGuiRenderer(AplConfigurationPtr config, AplCoreConnectionManagerPtr aplCoreConnectionManager);
 
+    /**
+     * Destructor, stops the prefetch thread once the prefetch it is running, if any, has completed
+     */
+    ~AplCoreGuiRenderer();
+
     void setViewhostConfig(const AplViewhostConfigPtr& viewhostConfig);
 
     /**
-     * Renders the given template document and data payload through Apl Core
+     * Renders the given template document and data payload through Apl Core, restoring it from the document cache
+     * if it was inflated before with the same data and viewports. With data-only renders enabled, new data for the
+     * displayed document is applied to it in place.
      * @param document Template
      * @param data Payload
      * @param supportedViewports SupportedViewports
@@ -61,6 +75,40 @@ public:
         const std::string& supportedViewports,
         const std::string& token);
 
+    /**
+     * Renders the given parsed template document and data payload through Apl Core, taking ownership of both so that
+     * neither is copied or serialized again before inflation
+     * @param document Parsed template
+     * @param data Parsed payload, which must own its JSON
+     * @param supportedViewports SupportedViewports
+     * @param token The token for APL payload, empty string otherwise
+     */
+    void renderDocument(
+        apl::JsonData&& document,
+        apl::JsonData&& data,
+        const std::string& supportedViewports,
+        const std::string& token);
+
+    /**
+     * Prepares a document in the background ahead of its @c renderDocument: the content is created, the data bound
+     * and its imports downloaded into the package cache. A later @c renderDocument with the same document and data
+     * uses the prepared content and goes straight to inflation. Prefetches run one at a time on a single background
+     * thread and only the most recent is kept: a superseded prefetch which has not started is skipped, and one which
+     * is running stops at its next step, without blocking the caller.
+     * @param document Template
+     * @param data Payload
+     */
+    void prefetchDocument(const std::string& document, const std::string& data);
+
+    /**
+     * Enables data-only renders. The datasources of documents rendered from strings are then bound as live data, and
+     * rendering the displayed document again within the same token scope applies the changed values to it instead of
+     * inflating it again, so that only the affected components are updated. Changes to arrays, which may feed the
+     * children of multi-child components, still render a new document.
+     * @param enabled Whether data-only renders are enabled
+     */
+    void setDataOnlyRenderEnabled(bool enabled);
+
     /**
      * Clears the currently rendered document
      *
@@ -88,6 +136,63 @@ public:
     void interruptCommandSequence();
 
 private:
+    /**
+     * Binds the parsed datasources to the parameters of the main template
+     * @param content The content to bind to
+     * @param data Parsed payload, which must own its JSON
+     */
+    static void bindData(const apl::ContentPtr& content, apl::JsonData&& data);
+
+    /**
+     * Creates the content for a document and loads its packages, reporting any failure
+     * @param document Parsed template
+     * @param data Parsed payload, which must own its JSON
+     * @param token The token for APL payload, empty string otherwise
+     * @return The ready content, or nullptr if it failed
+     */
+    apl::ContentPtr createContent(apl::JsonData&& document, apl::JsonData&& data, const std::string& token);
+
+    /**
+     * Moves the mainTemplate parameters which are bound to objects into live maps, removing them from the document,
+     * and keeps the values of the other parameters
+     * @param document The parsed document to remove the parameters from
+     * @param sources The parsed payload
+     * @return The live maps by parameter name
+     */
+    AplCoreConnectionManager::LiveDataMap bindLiveParameters(rapidjson::Document& document, const rapidjson::Value& sources);
+
+    /**
+     * Applies new data to the displayed document if it was rendered from the same document within the same token
+     * scope and the changes can be made in place
+     * @return true if the data was applied
+     */
+    bool renderDataOnly(const std::string& document, const std::string& data, const std::string& token);
+
+    /**
+     * Forgets the live document, so that the next render inflates a new one
+     */
+    void clearLiveDocument();
+
+    /**
+     * Takes the prefetched content if it was prefetched for the given document and data, waiting for the prefetch to
+     * complete if needed.
+     * @return The prepared content, or nullptr if there is none or the prefetch failed
+     */
+    apl::ContentPtr takePrefetchedContent(const std::string& document, const std::string& data);
+
+    /**
+     * The prefetch thread loop, runs the most recent prefetch request until stopped
+     */
+    void runPrefetches();
+
+    /**
+     * @param generation The generation of a prefetch
+     * @return true if a later prefetch or a viewport change has superseded the prefetch
+     */
+    bool isPrefetchSuperseded(uint64_t generation) const {
+        return generation != m_prefetchGeneration;
+    }
+
     AplConfigurationPtr m_aplConfiguration;
 
     /**
@@ -100,6 +205,62 @@ private:
      * Used to cover the gap in time between request to render and any incoming clear events.
      */
     bool m_isDocumentCleared;
+
+    /// The mutex protecting the prefetch
+    std::mutex m_prefetchMutex;
+
+    /// The document and data of the most recent prefetch
+    std::string m_prefetchDocument;
+    std::string m_prefetchData;
+
+    /// The content being prepared by the most recent prefetch
+    std::future<apl::ContentPtr> m_prefetchContent;
+
+    /// A prefetch waiting for the prefetch thread
+    struct PrefetchRequest {
+        std::string document;
+        std::string data;
+        apl::Metrics metrics;
+        apl::RootConfig rootConfig;
+        std::promise<apl::ContentPtr> content;
+    };
+
+    /// The most recent prefetch if the prefetch thread has not started it yet
+    std::unique_ptr<PrefetchRequest> m_prefetchRequest;
+
+    /// Incremented whenever the prefetched content is superseded, so that a running prefetch stops early
+    std::atomic<uint64_t> m_prefetchGeneration;
+
+    /// Whether the prefetch thread should exit
+    bool m_prefetchStopping;
+
+    /// Signalled when a prefetch is requested or the prefetch thread is stopping
+    std::condition_variable m_prefetchCondition;
+
+    /// The thread running the prefetches, started by the first one
+    std::thread m_prefetchThread;
+
+    /// A mainTemplate parameter bound to a live map
+    struct LiveParameter {
+        apl::LiveMapPtr liveMap;
+        /// The value currently in the live map
+        rapidjson::Document value;
+    };
+
+    /// Whether data-only renders are enabled
+    bool m_dataOnlyRenderEnabled;
+
+    /// The content, document and token scope of the last document rendered with live parameters
+    apl::ContentPtr m_liveContent;
+    std::string m_liveDocument;
+    std::string m_liveTokenScope;
+
+    /// The live parameters of @c m_liveContent by name
+    std::unordered_map<std::string, LiveParameter> m_liveParameters;
+
+    /// The values of the other mainTemplate parameters of @c m_liveContent by name, which must not change for data
+    /// to be applied in place
+    std::unordered_map<std::string, rapidjson::Document> m_staticParameters;
 };
 }  // namespace APLClient
 
@@ -0,0 +1,74 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APL_CLIENT_LIBRARY_APL_CORE_HASH_H_
+#define APL_CLIENT_LIBRARY_APL_CORE_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace APLClient {
+
+/**
+ * The 64 bit FNV-1a hash the client uses for its cache keys and fingerprints. It is fast and well distributed, but not
+ * collision free, so a key built from it is checked against what it stands for wherever a collision matters.
+ */
+namespace AplCoreHash {
+
+/// The value a hash starts from
+static const uint64_t OFFSET_BASIS = 14695981039346656037ULL;
+
+/// The multiplier applied for each byte
+static const uint64_t PRIME = 1099511628211ULL;
+
+/**
+ * Adds bytes to a hash.
+ * @param hash The hash, started from @c OFFSET_BASIS
+ * @param data The bytes
+ * @param length The number of bytes
+ */
+inline void hashBytes(uint64_t& hash, const void* data, size_t length) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= PRIME;
+    }
+}
+
+/**
+ * Adds the representation of a scalar to a hash.
+ * @param hash The hash, started from @c OFFSET_BASIS
+ * @param value The scalar
+ */
+template<typename T>
+inline void hashScalar(uint64_t& hash, T value) {
+    hashBytes(hash, &value, sizeof(value));
+}
+
+/**
+ * @param data The bytes
+ * @param length The number of bytes
+ * @return The hash of the bytes
+ */
+inline uint64_t hash(const void* data, size_t length) {
+    uint64_t result = OFFSET_BASIS;
+    hashBytes(result, data, length);
+    return result;
+}
+
+}  // namespace AplCoreHash
+}  // namespace APLClient
+
+#endif  // APL_CLIENT_LIBRARY_APL_CORE_HASH_H_
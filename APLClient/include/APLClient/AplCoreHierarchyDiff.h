@@ -0,0 +1,109 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APL_CLIENT_LIBRARY_APL_CORE_HIERARCHY_DIFF_H_
+#define APL_CLIENT_LIBRARY_APL_CORE_HIERARCHY_DIFF_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+namespace APLClient {
+
+/**
+ * Keeps a compact fingerprint of the last component hierarchy sent to the viewhost, so that a new hierarchy for the
+ * same document, such as the one following a reinflate, can be sent as a diff against the components the viewhost
+ * already has.
+ *
+ * The fingerprint holds the uid, type and a hash of every property of each component. Children of a matched component
+ * are matched first by type and properties, and then in order by type, so that unchanged components keep their place
+ * even when their uid changed. The diff is an object with:
+ * - "removed": the uids of the components removed, with their subtree
+ * - "updated": for each matched component whose uid or properties changed, its previous "uid", its "newUid" if it
+ *   changed, and the "properties" which changed, null for a property no longer set
+ * - "added": for each new component, its "parent" uid and the serialized "component" with its subtree
+ * - "children": the ordered child uids of each parent whose children were added, removed or reordered
+ *
+ * and is applied by the viewhost in that order. The uids in "added" and "children" are the new uids.
+ */
+class AplCoreHierarchyDiff {
+public:
+    /**
+     * Records the hierarchy sent in full.
+     * @param hierarchy The serialized top component
+     */
+    void record(const rapidjson::Value& hierarchy);
+
+    /**
+     * Computes the diff from the recorded hierarchy and records the new one. Fails when there is no recorded
+     * hierarchy, or when the top component changed type, in which case nothing is recorded.
+     * @param hierarchy The serialized top component, the subtrees of added components are moved out of it
+     * @param allocator The allocator of the diff
+     * @param diff Set to the diff on success
+     * @return true if the diff was computed
+     */
+    bool diff(rapidjson::Value& hierarchy, rapidjson::Document::AllocatorType& allocator, rapidjson::Value& diff);
+
+    /**
+     * Marks a component whose properties were sent to the viewhost since the hierarchy was recorded, so that the next
+     * diff sends all of its properties.
+     * @param uid The unique id of the component
+     */
+    void invalidate(const std::string& uid);
+
+    /**
+     * Forgets the recorded hierarchy.
+     */
+    void clear();
+
+    /**
+     * @return true if no hierarchy is recorded
+     */
+    bool empty() const {
+        return m_root.uid.empty();
+    }
+
+private:
+    struct Fingerprint {
+        std::string uid;
+        uint64_t type = 0;
+        /// The hash of all properties
+        uint64_t hash = 0;
+        /// The hash of each property, in serialization order
+        std::vector<std::pair<std::string, uint64_t>> properties;
+        std::vector<Fingerprint> children;
+    };
+
+    struct Diff;
+
+    static void fingerprint(const rapidjson::Value& component, Fingerprint& fingerprint);
+
+    static void fingerprintTree(const rapidjson::Value& component, Fingerprint& fingerprint);
+
+    void diffComponent(const Fingerprint& previous, rapidjson::Value& component, Fingerprint& fingerprint, Diff& diff);
+
+    Fingerprint m_root;
+
+    /// The components whose recorded properties may no longer match the viewhost
+    std::unordered_set<std::string> m_invalidated;
+};
+
+}  // namespace APLClient
+
+#endif  // APL_CLIENT_LIBRARY_APL_CORE_HIERARCHY_DIFF_H_
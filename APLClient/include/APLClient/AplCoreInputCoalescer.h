@@ -0,0 +1,89 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APL_CLIENT_LIBRARY_APL_CORE_INPUT_COALESCER_H_
+#define APL_CLIENT_LIBRARY_APL_CORE_INPUT_COALESCER_H_
+
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include <rapidjson/document.h>
+
+namespace APLClient {
+
+/**
+ * Queues inbound viewhost messages which only carry a latest state, such as pointer moves and scroll positions, so
+ * that the messages arriving between two frames are applied once.
+ *
+ * Each message has a key naming the state it sets. A message supersedes the queued message with the same key, which
+ * is dropped, and is queued after every other queued message. Messages are otherwise kept in the order they arrived.
+ * The coalescer is not thread safe.
+ */
+class AplCoreInputCoalescer {
+public:
+    using Handler = std::function<void(const std::string& type, const rapidjson::Value& payload)>;
+
+    /**
+     * Queues a message, dropping the queued message with the same key.
+     * @param type The message type
+     * @param key The state the message sets, unique across message types
+     * @param payload The message payload, copied
+     */
+    void push(const std::string& type, const std::string& key, const rapidjson::Value& payload);
+
+    /**
+     * Removes the queued messages and passes them to a handler in order.
+     * @param handler The handler of each message
+     */
+    void flush(const Handler& handler);
+
+    /**
+     * Drops the queued messages.
+     */
+    void clear();
+
+    /**
+     * @return true if no message is queued
+     */
+    bool empty() const {
+        return m_entries.empty();
+    }
+
+    /**
+     * @return The number of messages queued
+     */
+    size_t size() const {
+        return m_entries.size();
+    }
+
+private:
+    struct Entry {
+        std::string type;
+        std::string key;
+        rapidjson::Document payload;
+    };
+
+    /// The queued messages in order
+    std::list<Entry> m_entries;
+
+    /// The queued messages by key
+    std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+};
+
+}  // namespace APLClient
+
+#endif  // APL_CLIENT_LIBRARY_APL_CORE_INPUT_COALESCER_H_
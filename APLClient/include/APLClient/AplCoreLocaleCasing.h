@@ -0,0 +1,58 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APLCLIENTLIBRARY_APLCORELOCALECASING_H
+#define APLCLIENTLIBRARY_APLCORELOCALECASING_H
+
+#include <string>
+
+namespace APLClient {
+
+    /**
+     * In-process upper and lower casing of UTF-8 strings.
+     *
+     * Covers ASCII, Latin-1, Latin Extended-A, basic Greek and Cyrillic, and treats CJK and Hangul as caseless.
+     * Anything it cannot decide without locale data is reported as such, so that the caller can ask the viewhost:
+     * the dotted and dotless i of Turkish and Azerbaijani, Lithuanian accents, the Greek final sigma, characters
+     * outside the covered blocks and invalid UTF-8.
+     */
+    class AplCoreLocaleCasing {
+    public:
+        /**
+         * Upper cases a string
+         *
+         * @param value The UTF-8 string to convert
+         * @param locale The BCP-47 locale of the string
+         * @param result Set to the converted string on success
+         * @return true if the string was converted, false if it requires locale data not available locally
+         */
+        static bool toUpperCase(const std::string &value, const std::string &locale, std::string &result);
+
+        /**
+         * Lower cases a string
+         *
+         * @param value The UTF-8 string to convert
+         * @param locale The BCP-47 locale of the string
+         * @param result Set to the converted string on success
+         * @return true if the string was converted, false if it requires locale data not available locally
+         */
+        static bool toLowerCase(const std::string &value, const std::string &locale, std::string &result);
+
+    private:
+        static bool toCase(const std::string &value, const std::string &locale, bool upper, std::string &result);
+    };
+
+}  // namespace APLClient
+#endif //APLCLIENTLIBRARY_APLCORELOCALECASING_H
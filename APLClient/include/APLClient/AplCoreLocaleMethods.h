@@ -16,12 +16,18 @@
 #ifndef APLCLIENTLIBRARY_APLCORELOCALEMETHODS_H
 #define APLCLIENTLIBRARY_APLCORELOCALEMETHODS_H
 
+#include <unordered_map>
+
 #include "AplConfiguration.h"
 #include "AplCoreConnectionManager.h"
 #include "Telemetry/AplMetricsRecorderInterface.h"
 
 namespace APLClient {
 
+    /**
+     * Locale methods for APL Core. Strings are cased locally with @c AplCoreLocaleCasing where possible, and
+     * by the viewhost otherwise.
+     */
     class AplCoreLocaleMethods : public apl::LocaleMethods {
     public:
         /**
@@ -41,6 +47,9 @@ namespace APLClient {
         std::weak_ptr<AplCoreConnectionManager> m_aplCoreConnectionManager;
 
         AplConfigurationPtr m_aplConfiguration;
+
+        /// Strings cased by the viewhost, keyed by method, locale and value
+        std::unordered_map<std::string, std::string> m_viewhostResults;
     };
 
 }  // namespace APLClient
@@ -0,0 +1,141 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APL_CLIENT_LIBRARY_APL_CORE_PACKAGE_CACHE_H_
+#define APL_CLIENT_LIBRARY_APL_CORE_PACKAGE_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <rapidjson/document.h>
+
+namespace APLClient {
+
+/**
+ * A cache of downloaded APL import packages such as alexa-layouts and alexa-styles.
+ *
+ * Packages are versioned and immutable, so they are keyed on their name, version and source and never expire. The
+ * memory tier holds a bounded number of parsed packages, evicting the least recently used. The optional disk tier
+ * holds the package text, one file per package in a directory set with @c setDirectory, and survives restarts. Each
+ * file starts with the key of its package, so that a file named after a colliding hash is not taken for another.
+ *
+ * The cache is thread safe and is shared by every renderer created from one @c AplClientBinding.
+ */
+class AplCorePackageCache {
+public:
+    using Key = std::string;
+
+    /// The default maximum number of packages held in memory
+    static const size_t DEFAULT_MAX_ENTRIES = 64;
+
+    /**
+     * Constructor
+     * @param maxEntries The maximum number of packages held in memory before the least recently used is evicted
+     */
+    explicit AplCorePackageCache(size_t maxEntries = DEFAULT_MAX_ENTRIES);
+
+    /**
+     * Computes the cache key for an import.
+     * @param name The package name
+     * @param version The package version
+     * @param source The url the package is downloaded from
+     * @return The cache key
+     */
+    static Key makeKey(const std::string& name, const std::string& version, const std::string& source);
+
+    /**
+     * Enables the disk tier. The directory must exist and be writable, packages already stored in it are used.
+     * @param directory The directory to store packages in, or an empty string to disable the disk tier
+     */
+    void setDirectory(const std::string& directory);
+
+    /**
+     * Looks up a package in memory, then on disk, marking it as most recently used.
+     * @param key The cache key
+     * @param package Set to a copy of the parsed package if found
+     * @return true if the package was found
+     */
+    bool get(const Key& key, rapidjson::Document& package);
+
+    /**
+     * Stores a downloaded package, evicting the least recently used package from memory if full.
+     * @param key The cache key
+     * @param raw The package text, written to the disk tier if enabled
+     * @param package The parsed package
+     */
+    void put(const Key& key, const std::string& raw, const rapidjson::Value& package);
+
+    /**
+     * Removes every package held in memory, the disk tier is left untouched.
+     */
+    void clear();
+
+    /**
+     * @return The number of packages held in memory
+     */
+    size_t size();
+
+private:
+    /// A parsed package, which is not changed once stored so that it can be copied without holding the mutex
+    using Package = std::shared_ptr<const rapidjson::Document>;
+    using LruList = std::list<std::pair<Key, Package>>;
+
+    /**
+     * Adds a package to the memory tier, the mutex must be held.
+     */
+    void insert(const Key& key, Package package);
+
+    /**
+     * @return The disk tier file holding a package, the mutex must be held
+     */
+    std::string path(const Key& key) const;
+
+    /**
+     * Reads a package from the disk tier, checking that the file holds the package for the key.
+     * @param filePath The file to read
+     * @param key The cache key
+     * @param raw Set to the package text if found
+     * @return true if the file holds the package
+     */
+    static bool readFile(const std::string& filePath, const Key& key, std::string& raw);
+
+    /// The maximum number of packages held in memory
+    const size_t m_maxEntries;
+
+    /// The mutex protecting the cache
+    std::mutex m_mutex;
+
+    /// The disk tier directory, empty if disabled
+    std::string m_directory;
+
+    /// The number of disk tier files written, which names their temporary files
+    size_t m_tempFileCount;
+
+    /// The packages held in memory, most recently used first
+    LruList m_entries;
+
+    /// Index of @c m_entries by key
+    std::unordered_map<Key, LruList::iterator> m_index;
+};
+
+using AplCorePackageCachePtr = std::shared_ptr<AplCorePackageCache>;
+
+}  // namespace APLClient
+
+#endif  // APL_CLIENT_LIBRARY_APL_CORE_PACKAGE_CACHE_H_
@@ -0,0 +1,154 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APL_CLIENT_LIBRARY_APL_CORE_PACKAGE_DOWNLOADER_H_
+#define APL_CLIENT_LIBRARY_APL_CORE_PACKAGE_DOWNLOADER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "AplOptionsInterface.h"
+
+namespace APLClient {
+
+/**
+ * Downloads import packages through @c AplOptionsInterface::downloadResource on a bounded pool of worker threads.
+ *
+ * The pool is long lived and shared by every load, each of which requests its downloads through its own @c Batch.
+ * Requests are queued and started as soon as a worker is free, so up to the maximum number of downloads are always in
+ * flight and a slow download only holds up its own worker. Workers are started on demand, up to the maximum, and
+ * reused for every request.
+ */
+class AplCorePackageDownloader {
+private:
+    struct BatchState;
+
+public:
+    /**
+     * The downloads of one load. Completed downloads are returned by @c next in the order they complete, and only to
+     * the batch which requested them.
+     */
+    class Batch {
+    public:
+        /**
+         * Destructor, abandons the downloads not yet returned without waiting for them. Those not started are
+         * dropped, and those in flight are discarded when they complete.
+         */
+        ~Batch();
+
+        /**
+         * Queues a download.
+         * @param requestId The id returned with the download by @c next
+         * @param source The url to download
+         */
+        void request(uint32_t requestId, const std::string& source);
+
+        /**
+         * Waits for the next download of the batch to complete.
+         * @param requestId Set to the id of the completed request
+         * @param content Set to the downloaded content, empty if the download failed
+         * @return false if there are no outstanding requests
+         */
+        bool next(uint32_t& requestId, std::string& content);
+
+    private:
+        friend class AplCorePackageDownloader;
+
+        Batch(AplCorePackageDownloader& downloader, std::shared_ptr<BatchState> state);
+
+        AplCorePackageDownloader& m_downloader;
+        std::shared_ptr<BatchState> m_state;
+    };
+
+    /**
+     * Constructor
+     * @param aplOptions The options to download with
+     * @param maxConcurrentDownloads The maximum number of downloads in flight at once
+     */
+    AplCorePackageDownloader(AplOptionsInterfacePtr aplOptions, int maxConcurrentDownloads);
+
+    /**
+     * Destructor, waits for the downloads in flight and discards any that have not started. Every batch must have been
+     * destroyed before.
+     */
+    ~AplCorePackageDownloader();
+
+    /**
+     * Starts a batch of downloads. The batch must not outlive the downloader.
+     * @return The batch
+     */
+    std::unique_ptr<Batch> createBatch();
+
+private:
+    /// The downloads of a batch which are not yet returned, shared with the requests queued for it
+    struct BatchState {
+        /// Downloads completed but not yet returned by @c Batch::next, by id and content
+        std::deque<std::pair<uint32_t, std::string>> completed;
+
+        /// The number of requests not yet returned by @c Batch::next
+        size_t outstanding = 0;
+
+        /// Whether the batch was destroyed, and its downloads are no longer wanted
+        bool abandoned = false;
+
+        /// Signalled when a download of the batch completes
+        std::condition_variable completion;
+    };
+
+    /// A queued download
+    struct Request {
+        std::shared_ptr<BatchState> batch;
+        uint32_t requestId;
+        std::string source;
+    };
+
+    /**
+     * The worker loop, runs queued requests until stopped
+     */
+    void run();
+
+    AplOptionsInterfacePtr m_aplOptions;
+
+    /// The maximum number of workers
+    const size_t m_maxWorkers;
+
+    /// The mutex protecting the queue, the counters below and the state of every batch
+    std::mutex m_mutex;
+
+    /// Signalled when a request is queued or the downloader is stopping
+    std::condition_variable m_requestCondition;
+
+    /// Requests not yet started
+    std::deque<Request> m_requests;
+
+    /// The number of workers waiting for a request
+    size_t m_idleWorkers;
+
+    /// Whether the workers should exit
+    bool m_stopping;
+
+    std::vector<std::thread> m_workers;
+};
+
+}  // namespace APLClient
+
+#endif  // APL_CLIENT_LIBRARY_APL_CORE_PACKAGE_DOWNLOADER_H_
@@ -0,0 +1,118 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APLCLIENT_APL_APLCORETEXTMEASUREBATCH_H
+#define APLCLIENT_APL_APLCORETEXTMEASUREBATCH_H
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreorder"
+#pragma push_macro("DEBUG")
+#pragma push_macro("TRUE")
+#pragma push_macro("FALSE")
+#undef DEBUG
+#undef TRUE
+#undef FALSE
+#include <apl/apl.h>
+#pragma pop_macro("DEBUG")
+#pragma pop_macro("TRUE")
+#pragma pop_macro("FALSE")
+#pragma GCC diagnostic pop
+
+#include <unordered_set>
+#include <vector>
+
+#include "AplConfiguration.h"
+#include "AplCoreConnectionManager.h"
+#include "AplCoreMetrics.h"
+#include "AplCoreTextMeasureCache.h"
+
+namespace APLClient {
+
+/**
+ * Collects the text measurements requested during a dry run layout of a document so that they can be sent to the
+ * viewhost as a single @c measureBatch message, priming the @c AplCoreTextMeasureCache before the real inflation.
+ *
+ * Requests already in the cache are answered from it. Other requests are recorded and answered with an estimate
+ * based on their constraints. Where the real layout asks for the same constraints, which is the case for text laid
+ * out at an exact width such as items of a list, the real measurement is then a cache hit.
+ */
+class AplCoreTextMeasureBatch : public apl::TextMeasurement {
+public:
+    /**
+     * Constructor
+     *
+     * @param aplCoreMetrics The metrics the document will be inflated with
+     * @param config The APL configuration holding the measurement cache
+     */
+    AplCoreTextMeasureBatch(AplCoreMetricsPtr aplCoreMetrics, AplConfigurationPtr config);
+
+    /// @name apl::TextMeasurement Functions
+    /// @{
+    apl::LayoutSize measure(
+        apl::Component* component,
+        float width,
+        apl::MeasureMode widthMode,
+        float height,
+        apl::MeasureMode heightMode) override;
+
+    float baseline(apl::Component* component, float width, float height) override;
+    /// @}
+
+    /**
+     * @return The number of distinct measurements recorded
+     */
+    size_t size() const {
+        return m_keys.size();
+    }
+
+    /**
+     * Sends the recorded measurements to the viewhost as one message and stores the replies in the cache.
+     *
+     *     { "type": "measureBatch",
+     *       "payload": [ MEASURE_PAYLOAD, ... ] }
+     *
+     * where each entry is the payload of a @c measure message. The reply holds the results in the same order:
+     *
+     *     { "type": "measureBatch",
+     *       "payload": [ { "width": FLOAT, "height": FLOAT }, ... ] }
+     *
+     * @param aplCoreConnectionManager The connection manager to send with
+     * @return The number of measurements added to the cache
+     */
+    size_t send(AplCoreConnectionManager& aplCoreConnectionManager);
+
+private:
+    AplCoreMetricsPtr m_aplCoreMetrics;
+
+    AplConfigurationPtr m_aplConfiguration;
+
+    AplCoreTextMeasureCachePtr m_textMeasureCache;
+
+    /// The message holding the recorded requests
+    AplCoreViewhostMessage m_message;
+
+    /// The recorded requests, allocated from @c m_message
+    rapidjson::Value m_requests;
+
+    /// The cache keys of the recorded requests, in the order of @c m_requests
+    std::vector<AplCoreTextMeasureCache::Key> m_keys;
+
+    /// The cache keys already recorded
+    std::unordered_set<AplCoreTextMeasureCache::Key> m_recorded;
+};
+
+}  // namespace APLClient
+
+#endif  // APLCLIENT_APL_APLCORETEXTMEASUREBATCH_H
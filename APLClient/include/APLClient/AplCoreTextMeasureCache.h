@@ -0,0 +1,141 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APL_CLIENT_LIBRARY_APL_CORE_TEXT_MEASURE_CACHE_H_
+#define APL_CLIENT_LIBRARY_APL_CORE_TEXT_MEASURE_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include <rapidjson/document.h>
+
+namespace APLClient {
+
+/**
+ * A bounded, least recently used cache of text measurements returned by the viewhost.
+ *
+ * Entries are keyed on a hash of the measurement-relevant serialized properties of a component together with the
+ * width/height constraints and measure modes. Identity and layout output properties (the unique id and any property
+ * prefixed with an underscore) are excluded, so identical text in different components shares one entry. Sizes are
+ * stored in viewhost units so the cache can be shared between renderers with different scaling.
+ *
+ * The cache is thread safe and is shared by every renderer created from one @c AplClientBinding.
+ */
+class AplCoreTextMeasureCache {
+public:
+    using Key = uint64_t;
+
+    /// A measurement result in viewhost units
+    struct Entry {
+        Entry(float width = 0, float height = 0) :
+                width{width},
+                height{height},
+                hasBaseline{false},
+                baseline{0},
+                lineCount{0},
+                lastLineWidth{0} {}
+
+        float width;
+        float height;
+        /// Whether the viewhost returned the text metrics below with the size
+        bool hasBaseline;
+        float baseline;
+        int lineCount;
+        float lastLineWidth;
+    };
+
+    /// The default maximum number of entries held
+    static const size_t DEFAULT_MAX_ENTRIES = 2048;
+
+    /**
+     * Constructor
+     * @param maxEntries The maximum number of entries held before the least recently used is evicted
+     */
+    explicit AplCoreTextMeasureCache(size_t maxEntries = DEFAULT_MAX_ENTRIES);
+
+    /**
+     * Computes the cache key for a measurement request.
+     * @param properties The serialized component
+     * @param width The width constraint in viewhost units
+     * @param widthMode The width measure mode
+     * @param height The height constraint in viewhost units
+     * @param heightMode The height measure mode
+     * @return The cache key
+     */
+    static Key makeKey(const rapidjson::Value& properties, float width, int widthMode, float height, int heightMode);
+
+    /**
+     * Reads a measurement from the payload of a viewhost measure reply.
+     *
+     *     { "width": FLOAT, "height": FLOAT, "baseline": FLOAT, "lineCount": INT, "lastLineWidth": FLOAT }
+     *
+     * The baseline, line count and last line width are optional.
+     *
+     * @param payload The reply payload
+     * @param entry Set to the measurement if valid
+     * @return true if the payload held a valid measurement
+     */
+    static bool parseEntry(const rapidjson::Value& payload, Entry& entry);
+
+    /**
+     * Looks up a measurement, marking it as most recently used.
+     * @param key The cache key
+     * @param entry Set to the cached measurement if found
+     * @return true if the measurement was found
+     */
+    bool get(Key key, Entry& entry);
+
+    /**
+     * Stores a measurement, evicting the least recently used entry if the cache is full.
+     * @param key The cache key
+     * @param entry The measurement
+     */
+    void put(Key key, const Entry& entry);
+
+    /**
+     * Removes every entry, called when a configuration change may affect text layout.
+     */
+    void clear();
+
+    /**
+     * @return The number of entries held
+     */
+    size_t size();
+
+private:
+    using LruList = std::list<std::pair<Key, Entry>>;
+
+    /// The maximum number of entries held
+    const size_t m_maxEntries;
+
+    /// The mutex protecting the cache
+    std::mutex m_mutex;
+
+    /// The entries, most recently used first
+    LruList m_entries;
+
+    /// Index of @c m_entries by key
+    std::unordered_map<Key, LruList::iterator> m_index;
+};
+
+using AplCoreTextMeasureCachePtr = std::shared_ptr<AplCoreTextMeasureCache>;
+
+}  // namespace APLClient
+
+#endif  // APL_CLIENT_LIBRARY_APL_CORE_TEXT_MEASURE_CACHE_H_
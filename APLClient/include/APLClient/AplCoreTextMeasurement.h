@@ -16,6 +16,9 @@
 #ifndef APLCLIENT_APL_APLCORETEXTMEASUREMENT_H
 #define APLCLIENT_APL_APLCORETEXTMEASUREMENT_H
 
+#include <map>
+#include <string>
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wreorder"
 #pragma push_macro("DEBUG")
@@ -32,6 +35,7 @@
 
 #include "AplConfiguration.h"
 #include "AplCoreConnectionManager.h"
+#include "AplCoreTextMeasureCache.h"
 #include "Telemetry/AplMetricsRecorderInterface.h"
 
 namespace APLClient {
@@ -50,6 +54,33 @@ public:
         AplCoreConnectionManagerPtr aplCoreConnectionManager,
         AplConfigurationPtr config);
 
+    /**
+     * Constructor for a document inflated next to the live one. Until @c setLive is called the measurement uses the
+     * metrics and token of that document instead of those of the live document.
+     *
+     * @param aplCoreConnectionManager Pointer to the APL Core connection manager
+     * @param aplCoreMetrics The metrics of the document
+     * @param aplToken The token of the document
+     */
+    AplCoreTextMeasurement(
+        AplCoreConnectionManagerPtr aplCoreConnectionManager,
+        AplConfigurationPtr config,
+        AplCoreMetricsPtr aplCoreMetrics,
+        const std::string& aplToken);
+
+    /**
+     * Makes the measurement use the metrics and token of the live document, once its document has become the live one.
+     * Must not be called while the document is being inflated.
+     */
+    void setLive();
+
+    /**
+     * @return The number of measurements which were not answered from the cache so far
+     */
+    size_t getCacheMissCount() const {
+        return m_cacheMissCount;
+    }
+
     /// @name apl::TextMeasurement Functions
     /// @{
     virtual apl::LayoutSize measure(
@@ -65,9 +96,32 @@ public:
 private:
     std::weak_ptr<AplCoreConnectionManager> m_aplCoreConnectionManager;
 
+    /// The metrics and token of a document which is not the live one yet, or null and empty once it is
+    AplCoreMetricsPtr m_documentMetrics;
+    std::string m_documentToken;
+
     AplConfigurationPtr m_aplConfiguration;
+    AplCoreTextMeasureCachePtr m_textMeasureCache;
     std::unique_ptr<Telemetry::AplCounterHandle> m_textMeasureCounter;
-    apl::LayoutSize GetValidMeasureResult(rapidjson::Document& result, AplCoreMetrics* aplCoreMetrics );
+    std::unique_ptr<Telemetry::AplCounterHandle> m_textMeasureCacheHitCounter;
+    std::unique_ptr<Telemetry::AplCounterHandle> m_textMeasureCacheMissCounter;
+    size_t m_cacheMissCount = 0;
+    bool GetValidMeasureResult(rapidjson::Document& result, AplCoreTextMeasureCache::Entry& entry);
+
+    /// @return The metrics of the measured document
+    AplCoreMetricsPtr getAplCoreMetrics(const AplCoreConnectionManagerPtr& aplCoreConnectionManager) const;
+
+    /// @return The token of the measured document
+    std::string getAPLToken(const AplCoreConnectionManagerPtr& aplCoreConnectionManager) const;
+
+    /**
+     * Keeps the baseline returned with the latest measurement of a component so @c baseline can be answered locally.
+     */
+    void rememberBaseline(apl::Component* component, const AplCoreTextMeasureCache::Entry& entry);
+
+    /// The latest measurement of each component which came with a baseline, by unique id. It is bounded, as the
+    /// measurement outlives the documents it measures.
+    std::map<std::string, AplCoreTextMeasureCache::Entry> m_measuredBaselines;
 
 };
 
@@ -0,0 +1,171 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APLCLIENT_APL_APLCOREVIEWHOSTINBOUNDMESSAGE_H
+#define APLCLIENT_APL_APLCOREVIEWHOSTINBOUNDMESSAGE_H
+
+#include <memory>
+#include <string>
+#include <rapidjson/document.h>
+
+#include "AplCoreViewhostMessage.h"
+
+namespace APLClient {
+
+/**
+ * The @c AplCoreViewhostInboundMessage is a parsed message received from the AplViewHost.
+ *
+ * { "type": STRING, "seqno": NUMBER, "payload": ANY }
+ *
+ * The message is parsed exactly once and the resulting document is shared between every stage of the receive path
+ * (@c shouldHandleMessage, @c handleMessage and any interceptors). Copies are cheap and refer to the same document,
+ * so a message may be handed across threads without being re-serialized.
+ */
+class AplCoreViewhostInboundMessage {
+public:
+    /**
+     * Parses a message received from the viewhost.
+     * @param message The JSON string of the message
+     * @return The parsed message, @c isValid will return false if the message could not be parsed
+     */
+    static AplCoreViewhostInboundMessage parse(const std::string& message) {
+        auto document = std::make_shared<rapidjson::Document>();
+        if (document->Parse(message.c_str()).HasParseError()) {
+            return AplCoreViewhostInboundMessage();
+        }
+        return AplCoreViewhostInboundMessage(document);
+    }
+
+    /**
+     * Creates a message from an already parsed document.
+     * @param document The parsed document
+     */
+    explicit AplCoreViewhostInboundMessage(std::shared_ptr<rapidjson::Document> document) :
+            mDocument{std::move(document)},
+            mRoot{mDocument.get()} {}
+
+    /**
+     * Creates a message from a member of an already parsed document. This allows a transport which wraps viewhost
+     * messages in its own envelope to pass the inner message through without re-serializing it.
+     * @param document The parsed document which owns the message
+     * @param key The member of @c document holding the message
+     */
+    AplCoreViewhostInboundMessage(std::shared_ptr<rapidjson::Document> document, const char* key) :
+            mDocument{std::move(document)},
+            mRoot{nullptr} {
+        if (mDocument && mDocument->IsObject()) {
+            auto it = mDocument->FindMember(key);
+            if (it != mDocument->MemberEnd()) {
+                mRoot = &it->value;
+            }
+        }
+    }
+
+    /**
+     * Constructs an invalid message
+     */
+    AplCoreViewhostInboundMessage() : mRoot{nullptr} {}
+
+    /**
+     * @return true if the message was parsed and is a JSON object
+     */
+    bool isValid() const {
+        return mRoot && mRoot->IsObject();
+    }
+
+    /**
+     * @return true if the message carries a string type
+     */
+    bool hasType() const {
+        if (!isValid()) {
+            return false;
+        }
+        auto it = mRoot->FindMember(MSG_TYPE_TAG);
+        return it != mRoot->MemberEnd() && it->value.IsString();
+    }
+
+    /**
+     * @return The message type, or an empty string if not present
+     */
+    std::string getType() const {
+        return hasType() ? (*mRoot)[MSG_TYPE_TAG].GetString() : "";
+    }
+
+    /**
+     * @return true if the message carries a sequence number
+     */
+    bool hasSequenceNumber() const {
+        if (!isValid()) {
+            return false;
+        }
+        auto it = mRoot->FindMember(MSG_SEQNO_TAG);
+        return it != mRoot->MemberEnd() && it->value.IsUint();
+    }
+
+    /**
+     * @return The sequence number of the message, or 0 if not present
+     */
+    unsigned int getSequenceNumber() const {
+        return hasSequenceNumber() ? (*mRoot)[MSG_SEQNO_TAG].GetUint() : 0;
+    }
+
+    /**
+     * @return The payload of the message, or nullptr if not present
+     */
+    const rapidjson::Value* getPayload() const {
+        if (!isValid()) {
+            return nullptr;
+        }
+        auto it = mRoot->FindMember(MSG_PAYLOAD_TAG);
+        return it != mRoot->MemberEnd() ? &it->value : nullptr;
+    }
+
+    /**
+     * @return The whole message, only valid to call if @c isValid returns true
+     */
+    const rapidjson::Value& get() const {
+        return *mRoot;
+    }
+
+    /**
+     * Creates a standalone document holding this message. When this is the last reference to a message which owns its
+     * whole document the parsed document is moved out, otherwise it is deep copied.
+     * @return The message as a document, or a NULL document if the message is invalid
+     */
+    rapidjson::Document toDocument() {
+        rapidjson::Document doc(rapidjson::kNullType);
+        if (!isValid()) {
+            return doc;
+        }
+        if (mRoot == mDocument.get() && mDocument.use_count() == 1) {
+            doc.Swap(*mDocument);
+            mRoot = nullptr;
+        } else {
+            doc.CopyFrom(*mRoot, doc.GetAllocator());
+        }
+        return doc;
+    }
+
+private:
+    /// The parsed document which owns the message
+    std::shared_ptr<rapidjson::Document> mDocument;
+
+    /// The message within @c mDocument
+    const rapidjson::Value* mRoot;
+};
+
+}  // namespace APLClient
+
+#endif  // APLCLIENT_APL_APLCOREVIEWHOSTINBOUNDMESSAGE_H
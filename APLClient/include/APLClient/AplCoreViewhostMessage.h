@@ -21,6 +21,8 @@
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
 
+#include "AplCoreViewhostMessageArena.h"
+
 namespace APLClient {
 
 /// The root GUI message type
@@ -39,18 +41,52 @@ const char MSG_PAYLOAD_TAG[] = "payload";
  */
 class AplCoreViewhostMessage {
 private:
+    /// The arena the message is built in, null if it owns its allocator
+    AplCoreViewhostMessageArena* mArena;
+
     rapidjson::Document mDocument;
 
+    /// The serialized message when not built in an arena
+    std::string mSerialized;
+
 public:
     /**
      * Constructor
      * @param type The type from this message
      */
-    AplCoreViewhostMessage(const std::string& type) : mDocument(rapidjson::kObjectType) {
+    AplCoreViewhostMessage(const std::string& type) : mArena{nullptr}, mDocument(rapidjson::kObjectType) {
         auto& alloc = mDocument.GetAllocator();
         mDocument.AddMember(MSG_TYPE_TAG, rapidjson::Value(type.c_str(), alloc).Move(), alloc);
     }
 
+    /**
+     * Constructor for a message built in an arena, the arena is held until the message is destroyed. If another
+     * message holds the arena the message is built with its own allocator instead.
+     * @param type The type from this message
+     * @param arena The arena to build the message in
+     */
+    AplCoreViewhostMessage(const std::string& type, AplCoreViewhostMessageArena& arena)
+        : mArena{arena.acquire() ? &arena : nullptr},
+          mDocument(rapidjson::kObjectType, mArena ? &arena.allocator() : nullptr) {
+        auto& alloc = mDocument.GetAllocator();
+        mDocument.AddMember(MSG_TYPE_TAG, rapidjson::Value(type.c_str(), alloc).Move(), alloc);
+    }
+
+    AplCoreViewhostMessage(AplCoreViewhostMessage&& other)
+        : mArena{other.mArena},
+          mDocument(std::move(other.mDocument)),
+          mSerialized(std::move(other.mSerialized)) {
+        other.mArena = nullptr;
+    }
+
+    ~AplCoreViewhostMessage() {
+        if (mArena) {
+            // The values live in the arena, let go of them before it is reused
+            mDocument.SetNull();
+            mArena->release();
+        }
+    }
+
     /**
      * Sets the sequence number for this message
      * @param sequenceNumber
@@ -85,21 +121,34 @@ public:
     }
 
     /**
-     * Retrieves the json string representing this message
-     * @return json string representation of message
+     * Retrieves the json string representing this message, preceded by @c AplCoreViewhostMessageArena::HEADROOM
+     * spaces
+     * @return json string representation of message, valid until the message is changed or destroyed
      */
-    std::string get() {
-        rapidjson::StringBuffer buffer;
-        buffer.Clear();
-        rapidjson::Writer<
-            rapidjson::StringBuffer,
-            rapidjson::UTF8<>,
-            rapidjson::UTF8<>,
-            rapidjson::CrtAllocator,
-            rapidjson::kWriteNanAndInfFlag>
-            writer(buffer);
+    const std::string& get() {
+        if (mArena) {
+            return mArena->serialize(mDocument);
+        }
+
+        mSerialized.assign(AplCoreViewhostMessageArena::HEADROOM, ' ');
+        AplCoreStringOutputStream stream(mSerialized);
+        AplCoreViewhostMessageArena::Writer writer(stream);
         mDocument.Accept(writer);
-        return std::string(buffer.GetString(), buffer.GetSize());
+        return mSerialized;
+    }
+
+    /**
+     * Takes the json string last returned by @c get, so that it can be handed over without copying
+     * @return json string representation of message
+     */
+    std::string take() {
+        if (mArena) {
+            return mArena->takeOutput();
+        }
+
+        std::string serialized;
+        serialized.swap(mSerialized);
+        return serialized;
     }
 
     /**
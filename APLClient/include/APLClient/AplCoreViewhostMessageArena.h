@@ -0,0 +1,164 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APLCLIENT_APL_APLCOREVIEWHOSTMESSAGEARENA_H
+#define APLCLIENT_APL_APLCOREVIEWHOSTMESSAGEARENA_H
+
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <rapidjson/allocators.h>
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+
+namespace APLClient {
+
+/**
+ * A rapidjson output stream writing straight into a @c std::string, so that the serialized bytes can be handed to
+ * the host transport without copying them out of a separate buffer.
+ */
+class AplCoreStringOutputStream {
+public:
+    typedef char Ch;
+
+    explicit AplCoreStringOutputStream(std::string& output) : m_output(&output) {}
+
+    void Put(Ch c) {
+        m_output->push_back(c);
+    }
+
+    void Flush() {}
+
+private:
+    std::string* m_output;
+};
+
+/**
+ * Reusable memory for building and serializing outbound viewhost messages.
+ *
+ * The arena holds a buffer which backs the pool allocator of one message at a time, and the buffers the message is
+ * serialized into. When a message is released the buffer grows to the size it needed, so that once a steady state is
+ * reached, such as a running animation sending similar dirty messages every frame, building and serializing a message
+ * does not allocate.
+ *
+ * A message which cannot acquire the arena because another message holds it falls back to its own allocator.
+ */
+class AplCoreViewhostMessageArena {
+public:
+    using Allocator = rapidjson::MemoryPoolAllocator<>;
+
+    using Writer = rapidjson::Writer<
+        AplCoreStringOutputStream,
+        rapidjson::UTF8<>,
+        rapidjson::UTF8<>,
+        rapidjson::CrtAllocator,
+        rapidjson::kWriteNanAndInfFlag>;
+
+    /// The initial size of the allocator buffer
+    static const size_t DEFAULT_CAPACITY = 16 * 1024;
+
+    /// The number of spaces serialized messages start with. A transport wrapping a message in an envelope of its own
+    /// may write the start of the envelope over them rather than move the message to make room for it.
+    static const size_t HEADROOM = 64;
+
+    /// The size above which buffers are not kept between messages, so that a one off large message such as a
+    /// hierarchy does not hold on to its memory
+    static const size_t MAX_RETAINED_CAPACITY = 1024 * 1024;
+
+    /**
+     * Constructor
+     * @param initialCapacity The initial size of the allocator buffer
+     */
+    explicit AplCoreViewhostMessageArena(size_t initialCapacity = DEFAULT_CAPACITY);
+
+    ~AplCoreViewhostMessageArena();
+
+    AplCoreViewhostMessageArena(const AplCoreViewhostMessageArena&) = delete;
+    AplCoreViewhostMessageArena& operator=(const AplCoreViewhostMessageArena&) = delete;
+
+    /**
+     * Takes the arena for a message.
+     * @return true if the arena was free, after which @c allocator may be used until @c release
+     */
+    bool acquire();
+
+    /**
+     * Returns the arena after the message built with it is done with, freeing all its memory at once.
+     */
+    void release();
+
+    /**
+     * @return The allocator of the message holding the arena
+     */
+    Allocator& allocator() {
+        return *m_allocator;
+    }
+
+    /**
+     * Serializes a value into the output buffer of the arena, after @c HEADROOM spaces.
+     * @param value The value to serialize
+     * @return The serialized value, valid until the arena is released
+     */
+    const std::string& serialize(const rapidjson::Value& value);
+
+    /**
+     * Takes the output of the last @c serialize without copying it. The arena starts over with a new output buffer
+     * of the same capacity, up to @c MAX_RETAINED_CAPACITY.
+     * @return The serialized value
+     */
+    std::string takeOutput();
+
+    /**
+     * @return The size of the allocator buffer
+     */
+    size_t capacity() const {
+        return m_buffer.size();
+    }
+
+    /**
+     * @return The capacity of the output buffer
+     */
+    size_t outputCapacity() const {
+        return m_output.capacity();
+    }
+
+private:
+    /// The memory backing the allocator
+    std::vector<char> m_buffer;
+
+    /// The storage the allocator is constructed in for each message
+    std::aligned_storage<sizeof(Allocator), alignof(Allocator)>::type m_allocatorStorage;
+
+    /// The allocator of the message holding the arena, null while it is free
+    Allocator* m_allocator;
+
+    /// Whether a message holds the arena
+    std::atomic_bool m_inUse;
+
+    /// The serialized message
+    std::string m_output;
+
+    /// The stream writing into @c m_output
+    AplCoreStringOutputStream m_outputStream;
+
+    /// The writer, reset for each message so that its stack is reused
+    Writer m_writer;
+};
+
+}  // namespace APLClient
+
+#endif  // APLCLIENT_APL_APLCOREVIEWHOSTMESSAGEARENA_H
@@ -0,0 +1,129 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef APL_CLIENT_LIBRARY_APL_CORE_VIEWHOST_REQUEST_CHANNEL_H_
+#define APL_CLIENT_LIBRARY_APL_CORE_VIEWHOST_REQUEST_CHANNEL_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "AplCoreViewhostInboundMessage.h"
+
+namespace APLClient {
+
+/**
+ * Tracks the requests sent to the viewhost which are awaiting a reply. Requests are keyed by the sequence number of
+ * the outbound message, so any number of them may be outstanding at once and replies may arrive in any order.
+ *
+ * Each request has a deadline, after which @c expire completes it with an invalid message.
+ */
+class AplCoreViewhostRequestChannel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Invoked with the reply to a request. The message is invalid if the request timed out or was cancelled.
+     * @note Replies are delivered on the thread which calls @c resolve, expiries on the thread which calls @c expire.
+     */
+    using ReplyCallback = std::function<void(const AplCoreViewhostInboundMessage& reply)>;
+
+    AplCoreViewhostRequestChannel();
+
+    /**
+     * Destructor, completes any outstanding requests with an invalid message
+     */
+    ~AplCoreViewhostRequestChannel();
+
+    /**
+     * Registers a request awaiting a reply, must be called before the request is sent.
+     * @param seqno The sequence number of the request
+     * @param deadline The time after which the request is considered failed
+     * @param callback The callback to invoke with the reply
+     */
+    void expect(unsigned int seqno, const Clock::time_point& deadline, ReplyCallback callback);
+
+    /**
+     * Registers a request awaiting a reply, must be called before the request is sent.
+     * @param seqno The sequence number of the request
+     * @param deadline The time after which the request is considered failed
+     * @return A future holding the reply
+     */
+    std::future<AplCoreViewhostInboundMessage> expect(unsigned int seqno, const Clock::time_point& deadline);
+
+    /**
+     * Completes the request which the message is a reply to.
+     * @param message The message received from the viewhost
+     * @return true if the message was a reply to an outstanding request
+     */
+    bool resolve(const AplCoreViewhostInboundMessage& message);
+
+    /**
+     * Completes a request with an invalid message.
+     * @param seqno The sequence number of the request
+     * @return true if the request was outstanding
+     */
+    bool cancel(unsigned int seqno);
+
+    /**
+     * Completes all outstanding requests with an invalid message.
+     */
+    void cancelAll();
+
+    /**
+     * Completes every request whose deadline has passed with an invalid message.
+     * @param now The current time
+     * @return The number of requests which expired
+     */
+    size_t expire(const Clock::time_point& now);
+
+    /**
+     * @return The earliest deadline of the outstanding requests, or @c Clock::time_point::max() if there are none
+     */
+    Clock::time_point nextDeadline();
+
+    /**
+     * @return true if any request is awaiting a reply. This does not take the lock.
+     */
+    bool hasPending() const {
+        return m_pendingCount > 0;
+    }
+
+private:
+    struct PendingRequest {
+        Clock::time_point deadline;
+        ReplyCallback callback;
+    };
+
+    /// Removes and returns the callbacks of all requests matching @c predicate
+    std::vector<ReplyCallback> take(const std::function<bool(unsigned int, const PendingRequest&)>& predicate);
+
+    /// The mutex protecting @c m_pending
+    std::mutex m_mutex;
+
+    /// The outstanding requests by sequence number
+    std::unordered_map<unsigned int, PendingRequest> m_pending;
+
+    /// The number of outstanding requests, readable without the lock
+    std::atomic<size_t> m_pendingCount;
+};
+
+}  // namespace APLClient
+
+#endif  // APL_CLIENT_LIBRARY_APL_CORE_VIEWHOST_REQUEST_CHANNEL_H_
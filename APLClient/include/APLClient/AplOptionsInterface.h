@@ -50,6 +50,19 @@ public:
      */
     virtual void sendMessage(const std::string& token, const std::string& payload) = 0;
 
+    /**
+     * Send the given payload to the APL Viewhost, handing over ownership of the buffer. Used for large messages such
+     * as a document hierarchy. Hosts whose transport can adopt the buffer should override this to avoid copying it,
+     * by default the payload is passed to @c sendMessage. The payload starts with
+     * @c AplCoreViewhostMessageArena::HEADROOM spaces, which a host wrapping it in an envelope may overwrite with the
+     * start of the envelope rather than move the message.
+     * @param token The APL token
+     * @param payload The serialized message
+     */
+    virtual void transferMessage(const std::string& token, std::string&& payload) {
+        sendMessage(token, payload);
+    }
+
     /**
      * Requests that the APL viewhost is reset to render a new APL document
      * @param token The APL token
@@ -116,7 +116,11 @@ enum class AplRenderingSegment {
     /** Corresponds to inflating the APL @c RootContext object */
     kRootContextInflation,
     /** Corresponds to performing a text measuring requested by APL during layout */
-    kTextMeasure
+    kTextMeasure,
+    /** Corresponds to a text measuring answered from the text measurement cache */
+    kTextMeasureCacheHit,
+    /** Corresponds to a text measuring which had to be sent to the viewhost */
+    kTextMeasureCacheMiss
 };
 
 /**
@@ -34,6 +34,10 @@ Telemetry::DownloadMetricsEmitterPtr AplClientBinding::createDownloadMetricsEmit
     return std::make_shared<Telemetry::DownloadMetricsEmitter>(m_aplConfiguration->getMetricsRecorder(), metricsPrefix);
 }
 
+void AplClientBinding::setPackageCacheDirectory(const std::string& directory) {
+    m_aplConfiguration->getPackageCache()->setDirectory(directory);
+}
+
 void AplClientBinding::onTelemetrySinkUpdated(APLClient::Telemetry::AplMetricsSinkInterfacePtr sink) {
     Telemetry::AplMetricsRecorderInterfacePtr recorder;
     if (sink) {
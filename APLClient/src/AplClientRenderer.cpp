@@ -84,22 +84,28 @@ AplClientRenderer::AplClientRenderer(AplConfigurationPtr config, std::string win
           m_aplConnectionManager{std::make_shared<AplCoreConnectionManager>(config)},
           m_aplGuiRenderer{new AplCoreGuiRenderer(config, m_aplConnectionManager)},
           m_lastReportedComplexity{0} {
-    m_messageHandlers.emplace("displayMetrics", [this](const std::string& message) { handleDisplayMetrics(message); });
+    m_messageHandlers.emplace("displayMetrics", [this](const AplCoreViewhostInboundMessage& message) {
+        handleDisplayMetrics(message);
+    });
 }
 
 bool AplClientRenderer::shouldHandleMessage(const std::string& message) {
     return m_aplConnectionManager->shouldHandleMessage(message);
 }
 
+bool AplClientRenderer::shouldHandleMessage(const AplCoreViewhostInboundMessage& message) {
+    return m_aplConnectionManager->shouldHandleMessage(message);
+}
+
 void AplClientRenderer::handleMessage(const std::string& message) {
-    rapidjson::Document doc;
-    if (!doc.Parse(message.c_str()).HasParseError()) {
-        if (doc.HasMember("type")) {
-            std::string type = doc["type"].GetString();
-            auto fit = m_messageHandlers.find(type);
-            if (fit != m_messageHandlers.end()) {
-                fit->second(message);
-            }
+    handleMessage(AplCoreViewhostInboundMessage::parse(message));
+}
+
+void AplClientRenderer::handleMessage(const AplCoreViewhostInboundMessage& message) {
+    if (message.hasType()) {
+        auto fit = m_messageHandlers.find(message.getType());
+        if (fit != m_messageHandlers.end()) {
+            fit->second(message);
         }
     }
     m_aplConnectionManager->handleMessage(message);
@@ -114,6 +120,32 @@ void AplClientRenderer::renderDocument(
     const std::string& data,
     const std::string& viewports,
     const std::string& token) {
+    addDocumentMetadata(token);
+    m_aplGuiRenderer->renderDocument(document, data, viewports, token);
+}
+
+void AplClientRenderer::renderDocument(
+    apl::JsonData&& document,
+    apl::JsonData&& data,
+    const std::string& viewports,
+    const std::string& token) {
+    addDocumentMetadata(token);
+    m_aplGuiRenderer->renderDocument(std::move(document), std::move(data), viewports, token);
+}
+
+void AplClientRenderer::prefetchDocument(const std::string& document, const std::string& data) {
+    m_aplGuiRenderer->prefetchDocument(document, data);
+}
+
+void AplClientRenderer::setDocumentCacheSize(size_t maxEntries) {
+    m_aplConnectionManager->setDocumentCacheSize(maxEntries);
+}
+
+void AplClientRenderer::setDataOnlyRenderEnabled(bool enabled) {
+    m_aplGuiRenderer->setDataOnlyRenderEnabled(enabled);
+}
+
+void AplClientRenderer::addDocumentMetadata(const std::string& token) {
     auto metricsRecorder = m_aplConfiguration->getMetricsRecorder();
     metricsRecorder->addMetadata(AplMetricsRecorderInterface::LATEST_DOCUMENT, "APL_TOKEN", token);
 
@@ -128,7 +160,6 @@ void AplClientRenderer::renderDocument(
     }
 
     m_aplToken = token;
-    m_aplGuiRenderer->renderDocument(document, data, viewports, token);
 }
 
 void AplClientRenderer::clearDocument() {
@@ -158,6 +189,10 @@ void AplClientRenderer::onUpdateTick() {
     m_aplConnectionManager->onUpdateTick();
 }
 
+std::chrono::steady_clock::time_point AplClientRenderer::getNextTickTime() {
+    return m_aplConnectionManager->getNextTickTime();
+}
+
 const std::string AplClientRenderer::getWindowId() {
     return m_windowId;
 }
@@ -196,7 +231,19 @@ void AplClientRenderer::restoreDocumentState(AplDocumentStatePtr documentState)
 }
 
 void AplClientRenderer::handleDisplayMetrics(const std::string& message) {
-    onMetricsReported(message);
+    handleDisplayMetrics(AplCoreViewhostInboundMessage::parse(message));
+}
+
+void AplClientRenderer::handleDisplayMetrics(const AplCoreViewhostInboundMessage& message) {
+    auto aplOptions = m_aplConfiguration->getAplOptions();
+    auto payload = message.getPayload();
+    if (payload) {
+        reportMetrics(*payload);
+    } else if (message.isValid()) {
+        aplOptions->logMessage(LogLevel::ERROR, "onMetricsReportedFailed", "Payload not found");
+    } else {
+        aplOptions->logMessage(LogLevel::ERROR, "onMetricsReportedFailed", "Error whilst parsing message");
+    }
     m_aplConfiguration->getAplOptions()->onRenderingEvent("", AplRenderingEvent::DOCUMENT_RENDERED);
 }
 
@@ -228,10 +275,8 @@ void AplClientRenderer::onRenderingEvent(AplRenderingEvent event) {
 
 void AplClientRenderer::onMetricsReported(const std::string& jsonPayload) {
     rapidjson::Document doc;
-    rapidjson::Value metricsPayload;
 
     auto aplOptions = m_aplConfiguration->getAplOptions();
-    auto metricsRecorder = m_aplConfiguration->getMetricsRecorder();
 
     if (doc.Parse(jsonPayload.c_str()).HasParseError()) {
         aplOptions->logMessage(LogLevel::ERROR, "onMetricsReportedFailed", "Error whilst parsing message");
@@ -242,7 +287,13 @@ void AplClientRenderer::onMetricsReported(const std::string& jsonPayload) {
         aplOptions->logMessage(LogLevel::ERROR, "onMetricsReportedFailed", "Payload not found");
         return;
     }
-    metricsPayload = doc["payload"];
+
+    reportMetrics(doc["payload"]);
+}
+
+void AplClientRenderer::reportMetrics(const rapidjson::Value& metricsPayload) {
+    auto aplOptions = m_aplConfiguration->getAplOptions();
+    auto metricsRecorder = m_aplConfiguration->getMetricsRecorder();
 
     if (metricsPayload.GetType() != rapidjson::Type::kArrayType) {
         aplOptions->logMessage(LogLevel::ERROR, "onMetricsReportedFailed", "Payload is not an array");
@@ -21,7 +21,9 @@ namespace APLClient {
 AplConfiguration::AplConfiguration(AplOptionsInterfacePtr options,
                                  Telemetry::AplMetricsRecorderInterfacePtr metricsRecorder)
         : m_aplOptions{options},
-          m_metricsRecorder{metricsRecorder} {
+          m_metricsRecorder{metricsRecorder},
+          m_textMeasureCache{std::make_shared<AplCoreTextMeasureCache>()},
+          m_packageCache{std::make_shared<AplCorePackageCache>()} {
     if (!m_metricsRecorder) {
         m_metricsRecorder = std::make_shared<Telemetry::NullAplMetricsRecorder>();
     }
@@ -41,4 +43,12 @@ void AplConfiguration::setMetricsRecorder(Telemetry::AplMetricsRecorderInterface
     }
 }
 
+AplCoreTextMeasureCachePtr AplConfiguration::getTextMeasureCache() const {
+    return m_textMeasureCache;
+}
+
+AplCorePackageCachePtr AplConfiguration::getPackageCache() const {
+    return m_packageCache;
+}
+
 }
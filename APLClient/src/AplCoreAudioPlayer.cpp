@@ -35,7 +35,12 @@ AplCoreAudioPlayer::create(
         payload.AddMember("playerId", rapidjson::Value(playerId, alloc).Move(), alloc);
         msg.setPayload(std::move(payload));
 
-        connectionManager->blockingSend(msg);
+        // Commands for this player are sent in order behind the create request, so don't stall the core on the reply
+        connectionManager->sendRequest(msg, [config](const AplCoreViewhostInboundMessage& reply) {
+            if (!reply.isValid()) {
+                config->getAplOptions()->logMessage(LogLevel::WARN, "createAudioPlayer", "Did not receive response");
+            }
+        });
     } else {
         auto aplOptions = config->getAplOptions();
         aplOptions->logMessage(LogLevel::WARN, __func__, "ConnectionManager does not exist. Can't create AudioPlayer.");
@@ -65,7 +70,7 @@ AplCoreAudioPlayer::AplCoreAudioPlayer(
 void
 AplCoreAudioPlayer::sendAudioPlayerCommand(const std::string& command, std::string optionalUrl) {
     if (auto connectionManager = m_aplCoreConnectionManager.lock()) {
-        auto msg = AplCoreViewhostMessage(command);
+        auto msg = AplCoreViewhostMessage(command, connectionManager->messageArena());
         auto& alloc = msg.alloc();
 
         auto aplCoreMetrics = connectionManager->aplCoreMetrics();
@@ -61,5 +61,15 @@ AplCoreAudioPlayerFactory::tick(const AplCoreConnectionManager& connectionManage
     }
 }
 
+bool
+AplCoreAudioPlayerFactory::hasPlayingPlayers() const {
+    for (auto& player : m_Players) {
+        if (player.second->isPlaying()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 
 } // namespace APLClient
@@ -13,15 +13,26 @@
  * permissions and limitations under the License.
  */
 
+#include <algorithm>
 #include <climits>
+#include <cmath>
+#include <thread>
+#include <vector>
 
+#include "APLClient/AplCoreHash.h"
 #include "APLClient/AplCoreTextMeasurement.h"
+#include "APLClient/AplCoreTextMeasureBatch.h"
 #include "APLClient/AplCoreLocaleMethods.h"
 #include "APLClient/AplCoreConnectionManager.h"
+#include "APLClient/AplCorePackageDownloader.h"
 #include "APLClient/AplCoreViewhostMessage.h"
 #include "APLClient/AplCoreAudioPlayerFactory.h"
 #include "APLClient/AplCoreMediaPlayerFactory.h"
 #include "APLClient/Extensions/AplCoreExtensionExecutor.h"
+#include "APLClient/Telemetry/DownloadMetricsEmitter.h"
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 
 #include <apl/datasource/dynamicindexlistdatasourceprovider.h>
 #include <apl/datasource/dynamictokenlistdatasourceprovider.h>
@@ -35,6 +46,15 @@ namespace APLClient {
 static const char* ALEXA_IMPORT_PATH = "https://arl.assets.apl-alexa.com/packages/%s/%s/document.json";
 /// The number of bytes read from the attachment with each read in the read loop.
 static const size_t CHUNK_SIZE(1024);
+/// The metrics prefix of import package downloads and cache hits
+static const char PACKAGE_METRICS_PREFIX[] = "APLClientPackageCache";
+
+/// An import package being downloaded
+struct PendingPackage {
+    apl::ImportRequest request;
+    AplCorePackageCache::Key key;
+    Telemetry::DownloadMetricsEmitterPtr metrics;
+};
 
 /// The keys used in ProvideState.
 static const char TOKEN_KEY[] = "token";
@@ -52,6 +72,18 @@ static const float SCALING_BIAS_CONSTANT = 10.0f;
 /// APL Scaling cost override
 static const bool SCALING_SHAPE_OVERRIDES_COST = true;
 
+/// Messages from this size on are handed over to the host rather than copied by it, smaller ones leave their buffer
+/// in the message arena for reuse
+static const size_t TRANSFER_MESSAGE_SIZE = 16 * 1024;
+
+/// The maximum number of documents remembered as measured from the cache, beyond which they are forgotten
+static const size_t MAX_PREMEASURED_DOCUMENTS = 64;
+
+/// Core timers further out than this are treated as no timer at all
+static const std::chrono::milliseconds MAX_TIMER_DELAY{std::chrono::hours(24)};
+/// How often a document being inflated in the background is checked for completion
+static const std::chrono::milliseconds STAGED_DOCUMENT_POLL_INTERVAL{16};
+
 /// The keys used in APL context creation.
 static const char HEIGHT_KEY[] = "height";
 static const char WIDTH_KEY[] = "width";
@@ -82,6 +114,30 @@ static const char ANIMATIONQUALITY_KEY[] = "animationQuality";
 static const char SUPPORTED_EXTENSIONS[] = "supportedExtensions";
 static const char EXTENSION_MESSAGE_KEY[] = "extension";
 static const char SCROLL_COMMAND_DURATION_KEY[] = "scrollCommandDuration";
+static const char SUPPORTS_MEASURE_BATCH_KEY[] = "supportsMeasureBatch";
+static const char SUPPORTS_FRAME_BATCH_KEY[] = "supportsFrameBatch";
+static const char FRAME_BATCH_KEY[] = "frameBatch";
+static const char SUPPORTS_DOCUMENT_SWAP_KEY[] = "supportsDocumentSwap";
+static const char SUPPORTS_HIERARCHY_DIFF_KEY[] = "supportsHierarchyDiff";
+static const char SUPPORTS_VIRTUALIZED_HIERARCHY_KEY[] = "supportsVirtualizedHierarchy";
+static const char VIRTUALIZATION_MARGIN_KEY[] = "virtualizationMargin";
+static const char MATERIALIZE_KEY[] = "materialize";
+static const char COMPONENTS_KEY[] = "components";
+static const char PLACEHOLDER_KEY[] = "placeholder";
+static const char BOUNDS_KEY[] = "_bounds";
+
+/// The properties through which a component can hide itself, whose changes are sent even when it is hidden
+static const apl::PropertyKey VISIBILITY_PROPERTIES[] = {
+    apl::kPropertyDisplay,
+    apl::kPropertyOpacity,
+    apl::kPropertyBounds,
+    apl::kPropertyTransform};
+
+/// The build message keys which, with the document itself, determine how a document inflates
+static const char* const BUILD_ENVIRONMENT_KEYS[] = {
+    WIDTH_KEY, HEIGHT_KEY, DPI_KEY, SHAPE_KEY, MODE_KEY,
+    AGENTNAME_KEY, AGENTVERSION_KEY, ALLOWOPENURL_KEY, DISALLOWVIDEO_KEY, DISALLOWDIALOG_KEY, DISALLOWEDITTEXT_KEY,
+    SCROLL_COMMAND_DURATION_KEY, ANIMATIONQUALITY_KEY};
 
 /// The keys used to provide SupportedExtensions from JS
 static const char URI_KEY[] = "uri";
@@ -168,8 +224,16 @@ AplCoreConnectionManager::AplCoreConnectionManager(AplConfigurationPtr config) :
         m_aplConfiguration{config},
         m_ScreenLock{false},
         m_SequenceNumber{0},
-        m_replyExpectedSequenceNumber{0},
-        m_blockingSendReplyExpected{false} {
+        m_measureBatchSupported{false},
+        m_frameBatchSupported{false},
+        m_frameBatching{false},
+        m_frameBatchSize{0},
+        m_tickRequested{false},
+        m_documentSwapSupported{false},
+        m_restoringCachedDocument{false},
+        m_hierarchyDiffSupported{false},
+        m_virtualizedHierarchySupported{false},
+        m_virtualizationMargin{-1} {
     m_StartTime = getCurrentTime();
 
     m_extensionManager = std::make_shared<AplCoreExtensionManager>();
@@ -193,6 +257,7 @@ AplCoreConnectionManager::AplCoreConnectionManager(AplConfigurationPtr config) :
     m_messageHandlers.emplace("isCharacterValid", [this](const rapidjson::Value& payload) { handleIsCharacterValid(payload); });
     m_messageHandlers.emplace("reInflate", [this](const rapidjson::Value& payload) { handleReInflate(payload); });
     m_messageHandlers.emplace("reHierarchy", [this](const rapidjson::Value& payload) { handleReHierarchy(payload); });
+    m_messageHandlers.emplace("materialize", [this](const rapidjson::Value& payload) { handleMaterialize(payload); });
     m_messageHandlers.emplace("extension", [this](const rapidjson::Value& payload) { handleExtensionMessage(payload); });
     m_messageHandlers.emplace("mediaLoaded", [this](const rapidjson::Value& payload) { mediaLoaded(payload); });
     m_messageHandlers.emplace("mediaLoadFailed", [this](const rapidjson::Value& payload) { mediaLoadFailed(payload); });
@@ -203,12 +268,195 @@ AplCoreConnectionManager::AplCoreConnectionManager(AplConfigurationPtr config) :
 }
 
 void AplCoreConnectionManager::setContent(const apl::ContentPtr content, const std::string& token) {
+    auto documentKey = std::move(m_nextDocumentKey);
+    auto liveData = std::move(m_nextLiveData);
+    m_nextDocumentKey.clear();
+    m_nextLiveData.clear();
+    if (canStageContent(content)) {
+        stageContent(content, token, documentKey, std::move(liveData));
+        return;
+    }
+
+    m_stagedDocument.reset();
+    resetContent(content, token, documentKey, std::move(liveData));
+}
+
+void AplCoreConnectionManager::resetContent(
+        const apl::ContentPtr& content,
+        const std::string& token,
+        const AplCoreDocumentCache::Key& documentKey,
+        LiveDataMap liveData) {
     m_Content = content;
     m_aplToken = token;
+    m_documentKey = documentKey;
+    m_liveData = std::move(liveData);
+    m_restoringCachedDocument = false;
     m_ConfigurationChange.clear();
     m_aplConfiguration->getAplOptions()->resetViewhost(token);
 }
 
+bool AplCoreConnectionManager::canStageContent(const apl::ContentPtr& content) const {
+    // Documents with extensions register them against the live root config, so they are built after a reset
+    return m_documentSwapSupported && m_Root && m_stagingRootConfig && !m_documentStateToRestore && content &&
+           content->isReady() && content->getExtensionRequests().empty();
+}
+
+/**
+ * Adds the data source providers to a root config. Providers hold the data sources of the root they inflate, so every
+ * root config which is inflated next to another gets its own.
+ */
+static void addDataSourceProviders(apl::RootConfig& rootConfig) {
+    rootConfig.dataSourceProvider(
+        apl::DynamicIndexListConstants::DEFAULT_TYPE_NAME,
+        std::make_shared<apl::DynamicIndexListDataSourceProvider>());
+
+    rootConfig.dataSourceProvider(
+        apl::DynamicTokenListConstants::DEFAULT_TYPE_NAME,
+        std::make_shared<apl::DynamicTokenListDataSourceProvider>());
+}
+
+void AplCoreConnectionManager::stageContent(
+        const apl::ContentPtr& content,
+        const std::string& token,
+        const AplCoreDocumentCache::Key& documentKey,
+        LiveDataMap liveData) {
+    auto aplOptions = m_aplConfiguration->getAplOptions();
+    std::unique_ptr<StagedDocument> staged{new StagedDocument()};
+    staged->content = content;
+    staged->token = token;
+    staged->documentKey = documentKey;
+    staged->liveData = std::move(liveData);
+
+    apl::ScalingOptions scalingOptions = {
+        m_ViewportSizeSpecifications, SCALING_BIAS_CONSTANT, SCALING_SHAPE_OVERRIDES_COST};
+    if (!scalingOptions.getSpecifications().empty()) {
+        staged->metrics = std::make_shared<AplCoreMetrics>(m_Metrics, scalingOptions);
+    } else {
+        staged->metrics = std::make_shared<AplCoreMetrics>(m_Metrics);
+    }
+
+    // The staged root gets its own players, text measurement, locale methods and data source providers, so that
+    // inflating it on another thread shares no state with the live document
+    staged->audioPlayerFactory = AplCoreAudioPlayerFactory::create(shared_from_this(), m_aplConfiguration);
+    staged->mediaPlayerFactory = AplCoreMediaPlayerFactory::create(shared_from_this(), m_aplConfiguration);
+    staged->textMeasurement =
+        std::make_shared<AplCoreTextMeasurement>(shared_from_this(), m_aplConfiguration, staged->metrics, token);
+    staged->rootConfig = *m_stagingRootConfig;
+    staged->rootConfig.set({
+                   {apl::RootProperty::kUTCTime, getCurrentTime().count()},
+                   {apl::RootProperty::kLocalTimeAdjustment, aplOptions->getTimezoneOffset().count()}
+               })
+               .measure(staged->textMeasurement)
+               .localeMethods(std::make_shared<AplCoreLocaleMethods>(shared_from_this(), m_aplConfiguration))
+               .audioPlayerFactory(staged->audioPlayerFactory)
+               .mediaPlayerFactory(staged->mediaPlayerFactory);
+    addDataSourceProviders(staged->rootConfig);
+    for (const auto& liveObject : staged->liveData) {
+        staged->rootConfig.liveData(liveObject.first, liveObject.second);
+    }
+
+    aplOptions->onRenderingEvent(token, AplRenderingEvent::INFLATE_BEGIN);
+    staged->startTime = getCurrentTime();
+
+    // The content is refreshed, its imports loaded and the root inflated on a detached thread fulfilling a promise
+    // rather than with std::async, so that a superseded staged document is dropped without waiting for it
+    auto aplCoreConnectionManager = shared_from_this();
+    auto metrics = m_Metrics;
+    auto stagedMetrics = staged->metrics->getMetrics();
+    auto rootConfig = staged->rootConfig;
+    auto cancelled = staged->cancelled;
+    auto promise = std::make_shared<std::promise<apl::RootContextPtr>>();
+    staged->root = promise->get_future();
+    std::thread([aplCoreConnectionManager, promise, cancelled, content, metrics, stagedMetrics, rootConfig]() {
+        apl::RootContextPtr root;
+        content->refresh(metrics, rootConfig);
+        if (!*cancelled && aplCoreConnectionManager->loadPackage(content) && !*cancelled) {
+            root = apl::RootContext::create(stagedMetrics, content, rootConfig);
+        }
+        promise->set_value(root);
+    }).detach();
+    m_stagedDocument = std::move(staged);
+}
+
+void AplCoreConnectionManager::swapStagedDocument() {
+    if (!m_stagedDocument ||
+        m_stagedDocument->root.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+        return;
+    }
+
+    auto aplOptions = m_aplConfiguration->getAplOptions();
+    std::unique_ptr<StagedDocument> staged = std::move(m_stagedDocument);
+    auto root = staged->root.get();
+    if (!root) {
+        // A build retries the other viewport specifications
+        aplOptions->logMessage(LogLevel::WARN, __func__, "Unable to prepare staged document, rebuilding");
+        resetContent(staged->content, staged->token, staged->documentKey, std::move(staged->liveData));
+        return;
+    }
+
+    // Release the activities of the outgoing document
+    aplOptions->onActivityEnded(m_aplToken, APL_COMMAND_EXECUTION);
+    if (m_ScreenLock) {
+        aplOptions->onActivityEnded(m_aplToken, APL_SCREEN_LOCK);
+        m_ScreenLock = false;
+    }
+    m_PendingEvents.clear();
+    // Queued input targets the components of the outgoing document, as after a reset
+    m_inputCoalescer.clear();
+
+    m_Content = staged->content;
+    m_aplToken = staged->token;
+    m_documentKey = staged->documentKey;
+    m_liveData = std::move(staged->liveData);
+    m_restoringCachedDocument = false;
+    m_Root = root;
+    m_RootConfig = staged->rootConfig;
+    m_AplCoreMetrics = staged->metrics;
+    m_audioPlayerFactory = staged->audioPlayerFactory;
+    m_mediaPlayerFactory = staged->mediaPlayerFactory;
+    staged->textMeasurement->setLive();
+    m_StartTime = staged->startTime;
+    m_ConfigurationChange.clear();
+
+    auto aplVersion = m_Content->getAPLVersion();
+    auto renderingOptionsMsg = AplCoreViewhostMessage(RENDERING_OPTIONS_KEY);
+    rapidjson::Value renderingOptions(rapidjson::kObjectType);
+    renderingOptions.AddMember(LEGACY_KARAOKE_KEY, aplVersion == "1.0", renderingOptionsMsg.alloc());
+    renderingOptions.AddMember(DOCUMENT_APL_VERSION_KEY, aplVersion, renderingOptionsMsg.alloc());
+    send(renderingOptionsMsg.setPayload(std::move(renderingOptions)));
+
+    bool supportsResizing = false;
+    if (auto documentSettings = m_Content->getDocumentSettings()) {
+        supportsResizing = documentSettings->getValue(SUPPORTS_RESIZING_KEY).asBoolean();
+    }
+    sendSupportsResizingMessage(supportsResizing);
+
+    aplOptions->onRenderingEvent(m_aplToken, AplRenderingEvent::INFLATE_END);
+
+    // The new hierarchy replaces the live one, the viewhost is not reset in between
+    sendViewhostScalingMessage();
+    sendDocumentBackgroundMessage(m_Content->getBackground(m_AplCoreMetrics->getMetrics(), m_RootConfig));
+    sendHierarchy(HIERARCHY_KEY);
+
+    auto idleTimeout = std::chrono::milliseconds(m_Content->getDocumentSettings()->idleTimeout(m_RootConfig));
+    aplOptions->onSetDocumentIdleTimeout(m_aplToken, idleTimeout);
+    aplOptions->onRenderDocumentComplete(m_aplToken, true, "");
+    cacheDocument();
+}
+
+void AplCoreConnectionManager::cacheDocument() {
+    // Extensions and live data hold state for the document outside of its root, so it cannot be restored from the
+    // root alone
+    if (!m_documentCache.isEnabled() || m_documentKey.empty() || m_buildEnvironment.empty() || !m_Root ||
+        !m_Content->getExtensionRequests().empty() || !m_liveData.empty()) {
+        return;
+    }
+    m_documentCache.put(
+        m_documentKey,
+        m_buildEnvironment,
+        std::make_shared<AplDocumentState>(m_aplToken, m_Root, m_AplCoreMetrics));
+}
+
 void AplCoreConnectionManager::setSupportedViewports(const std::string& jsonPayload) {
     rapidjson::Document doc;
     auto aplOptions = m_aplConfiguration->getAplOptions();
@@ -295,21 +543,25 @@ int AplCoreConnectionManager::getOptionalInt(
 }
 
 bool AplCoreConnectionManager::shouldHandleMessage(const std::string& message) {
-    if (m_blockingSendReplyExpected) {
-        rapidjson::Document doc;
-        if (doc.Parse(message.c_str()).HasParseError()) {
+    if (m_requestChannel.hasPending()) {
+        return shouldHandleMessage(AplCoreViewhostInboundMessage::parse(message));
+    }
+
+    return true;
+}
+
+bool AplCoreConnectionManager::shouldHandleMessage(const AplCoreViewhostInboundMessage& message) {
+    if (m_requestChannel.hasPending()) {
+        if (!message.isValid()) {
             auto aplOptions = m_aplConfiguration->getAplOptions();
             aplOptions->logMessage(LogLevel::ERROR, "shouldHandleMessageFailed", "Error whilst parsing message");
             return false;
         }
 
-        if (doc.HasMember(SEQNO_KEY) && doc[SEQNO_KEY].IsNumber()) {
-            unsigned int seqno = doc[SEQNO_KEY].GetUint();
-            if (seqno == m_replyExpectedSequenceNumber) {
-                m_blockingSendReplyExpected = false;
-                m_replyPromise.set_value(message);
-                return false;
-            }
+        if (m_requestChannel.resolve(message)) {
+            // Reply callbacks may have changed state which the next tick has to process
+            m_tickRequested = true;
+            return false;
         }
     }
 
@@ -317,33 +569,86 @@ bool AplCoreConnectionManager::shouldHandleMessage(const std::string& message) {
 }
 
 void AplCoreConnectionManager::handleMessage(const std::string& message) {
+    handleMessage(AplCoreViewhostInboundMessage::parse(message));
+}
+
+void AplCoreConnectionManager::handleMessage(const AplCoreViewhostInboundMessage& message) {
     auto aplOptions = m_aplConfiguration->getAplOptions();
-    rapidjson::Document doc;
-    if (doc.Parse(message.c_str()).HasParseError()) {
+    if (!message.isValid()) {
         aplOptions->logMessage(LogLevel::ERROR, "handleMessageFailed", "Error whilst parsing message");
         return;
     }
 
-    if (!doc.HasMember("type")) {
+    if (!message.hasType()) {
         aplOptions->logMessage(LogLevel::ERROR, "handleMessageFailed", "Unable to find type in message");
         return;
     }
-    std::string type = doc["type"].GetString();
+    std::string type = message.getType();
 
-    auto payload = doc.FindMember("payload");
-    if (payload == doc.MemberEnd()) {
+    auto payload = message.getPayload();
+    if (!payload) {
         aplOptions->logMessage(LogLevel::ERROR, "handleMessageFailed", "Unable to find payload in message");
         return;
     }
 
+    auto coalescingKey = getCoalescingKey(type, *payload);
+    if (!coalescingKey.empty()) {
+        // Applied at the next frame, unless superseded before then
+        m_inputCoalescer.push(type, coalescingKey, *payload);
+        m_tickRequested = true;
+        return;
+    }
+    // Queued input is applied before anything the viewhost sent after it
+    applyCoalescedInput();
+
     auto fit = m_messageHandlers.find(type);
     if (fit != m_messageHandlers.end()) {
-        fit->second(payload->value);
+        fit->second(*payload);
+        m_tickRequested = true;
     } else {
         aplOptions->logMessage(LogLevel::ERROR, "handleMessageFailed", "Unrecognized message type: " + type);
     }
 }
 
+std::string AplCoreConnectionManager::getCoalescingKey(const std::string& type, const rapidjson::Value& payload) {
+    // Only messages which carry a latest state are coalesced, pointer down, up and cancel events are never dropped
+    if (type == "handlePointerEvent") {
+        if (payload.HasMember(POINTEREVENTTYPE_KEY) && payload[POINTEREVENTTYPE_KEY].IsInt() &&
+            payload[POINTEREVENTTYPE_KEY].GetInt() == apl::kPointerMove && payload.HasMember(POINTERID_KEY) &&
+            payload[POINTERID_KEY].IsInt()) {
+            return "pointerMove#" + std::to_string(payload[POINTERID_KEY].GetInt());
+        }
+    } else if (type == "update") {
+        if (payload.HasMember("id") && payload["id"].IsString() && payload.HasMember("type") &&
+            payload["type"].IsInt() && payload["type"].GetInt() == apl::kUpdateScrollPosition) {
+            return std::string("scrollPosition#") + payload["id"].GetString();
+        }
+    } else if (type == "updateMedia") {
+        // Updates from media events may run event handlers, only the progress updates are coalesced
+        if (payload.HasMember("id") && payload["id"].IsString() && payload.HasMember(FROM_EVENT_KEY) &&
+            payload[FROM_EVENT_KEY].IsBool() && !payload[FROM_EVENT_KEY].GetBool()) {
+            return std::string("mediaState#") + payload["id"].GetString();
+        }
+    } else if (type == "mediaPlayerUpdateMediaState") {
+        if (payload.HasMember("playerId") && payload["playerId"].IsString()) {
+            return std::string("mediaPlayerState#") + payload["playerId"].GetString();
+        }
+    }
+    return "";
+}
+
+void AplCoreConnectionManager::applyCoalescedInput() {
+    if (m_inputCoalescer.empty()) {
+        return;
+    }
+    m_inputCoalescer.flush([this](const std::string& type, const rapidjson::Value& payload) {
+        auto fit = m_messageHandlers.find(type);
+        if (fit != m_messageHandlers.end()) {
+            fit->second(payload);
+        }
+    });
+}
+
 void AplCoreConnectionManager::handleConfigurationChange(const rapidjson::Value& configurationChange) {
     auto aplOptions = m_aplConfiguration->getAplOptions();
 
@@ -374,6 +679,8 @@ void AplCoreConnectionManager::handleConfigurationChange(const rapidjson::Value&
     // config change for theme
     if (configurationChange.HasMember(DOCTHEME_KEY) && configurationChange[DOCTHEME_KEY].IsString()) {
         configChange = configChange.theme(configurationChange[DOCTHEME_KEY].GetString());
+        // Cached text measurements may depend on the theme's fonts
+        m_aplConfiguration->getTextMeasureCache()->clear();
     }
     // config change for mode
     if (configurationChange.HasMember(MODE_KEY) &&
@@ -384,6 +691,7 @@ void AplCoreConnectionManager::handleConfigurationChange(const rapidjson::Value&
     // config change for fontScale
     if (configurationChange.HasMember(FONTSCALE_KEY) && configurationChange[FONTSCALE_KEY].IsFloat()) {
         configChange = configChange.fontScale(configurationChange[FONTSCALE_KEY].GetFloat());
+        m_aplConfiguration->getTextMeasureCache()->clear();
     }
     // config change for screenMode
     if (configurationChange.HasMember(SCREENMODE_KEY) &&
@@ -408,6 +716,11 @@ void AplCoreConnectionManager::handleConfigurationChange(const rapidjson::Value&
     }
     updateConfigurationChange(configChange);
     m_Root->configurationChange(configChange);
+
+    // The root no longer matches the configuration it was cached for
+    if (!m_documentKey.empty()) {
+        m_documentCache.erase(m_documentKey, m_buildEnvironment);
+    }
 }
 
 void AplCoreConnectionManager::handleUpdateDisplayState(const rapidjson::Value& displayState) {
@@ -543,6 +856,41 @@ void AplCoreConnectionManager::restoreDocumentState(AplDocumentStatePtr document
     m_aplConfiguration->getAplOptions()->resetViewhost(m_documentStateToRestore->token);
 }
 
+void AplCoreConnectionManager::setDocumentCacheSize(size_t maxEntries) {
+    m_documentCache.setMaxEntries(maxEntries);
+}
+
+bool AplCoreConnectionManager::restoreCachedDocument(
+        const AplCoreDocumentCache::Key& documentKey,
+        const std::string& token) {
+    auto documentState = m_documentCache.get(documentKey, m_buildEnvironment);
+    if (!documentState) {
+        return false;
+    }
+
+    m_aplConfiguration->getAplOptions()->logMessage(LogLevel::DBG, __func__, "Restoring cached document");
+    documentState->token = token;
+    restoreDocumentState(documentState);
+    m_documentKey = documentKey;
+    m_restoringCachedDocument = true;
+    return true;
+}
+
+void AplCoreConnectionManager::prepareContent(const AplCoreDocumentCache::Key& documentKey, LiveDataMap liveData) {
+    m_nextDocumentKey = documentKey;
+    m_nextLiveData = std::move(liveData);
+}
+
+bool AplCoreConnectionManager::isDisplaying(const apl::ContentPtr& content) const {
+    return m_Root && m_Content == content && !m_stagedDocument && !m_documentStateToRestore;
+}
+
+void AplCoreConnectionManager::onLiveDataUpdated(const std::string& token) {
+    m_aplToken = token;
+    m_tickRequested = true;
+    m_aplConfiguration->getAplOptions()->onRenderDocumentComplete(token, true, "");
+}
+
 void AplCoreConnectionManager::invokeExtensionEventHandler(
         const std::string& uri,
         const std::string& name,
@@ -752,48 +1100,90 @@ AplCoreConnectionManager::loadPackage(const apl::ContentPtr& content) {
             Telemetry::AplMetricsRecorderInterface::LATEST_DOCUMENT,
             "APL-Web.Content.error");
 
-    std::unordered_map<uint32_t, std::future<std::string>> packageContentByRequestId;
-    std::unordered_map<uint32_t, apl::ImportRequest> packageRequestByRequestId;
+    auto packageCache = m_aplConfiguration->getPackageCache();
+    // The batch is abandoned without waiting if the load fails early, its downloads in flight are discarded by the
+    // pool, which is held until then
+    std::shared_ptr<AplCorePackageDownloader> downloader;
+    std::unique_ptr<AplCorePackageDownloader::Batch> downloads;
+    std::unordered_map<uint32_t, PendingPackage> pendingPackages;
     while (content->isWaiting() && !content->isError()) {
+        // Schedule every newly requested package, imports of a package are requested as soon as it is added
         auto packages = content->getRequestedPackages();
-        cImports->incrementBy(packages.size());
-        unsigned int count = 0;
-        for (auto& package : packages) {
-            auto name = package.reference().name();
-            auto version = package.reference().version();
-            auto source = package.source();
-
-            aplOptions->logMessage(
-                    LogLevel::DBG, "loadPackage", "Requesting package: " + name + " " + version);
+        if (!packages.empty()) {
+            cImports->incrementBy(packages.size());
+            for (auto& package : packages) {
+                auto name = package.reference().name();
+                auto version = package.reference().version();
+                auto source = package.source();
+
+                if (source.empty()) {
+                    char sourceBuffer[CHUNK_SIZE];
+                    snprintf(sourceBuffer, CHUNK_SIZE, ALEXA_IMPORT_PATH, name.c_str(), version.c_str());
+                    source = sourceBuffer;
+                }
 
-            if (source.empty()) {
-                char sourceBuffer[CHUNK_SIZE];
-                snprintf(sourceBuffer, CHUNK_SIZE, ALEXA_IMPORT_PATH, name.c_str(), version.c_str());
-                source = sourceBuffer;
-            }
+                auto key = AplCorePackageCache::makeKey(name, version, source);
+                auto downloadMetrics =
+                    std::make_shared<Telemetry::DownloadMetricsEmitter>(metricsRecorder, PACKAGE_METRICS_PREFIX);
+                rapidjson::Document cachedPackage;
+                if (packageCache->get(key, cachedPackage)) {
+                    aplOptions->logMessage(
+                            LogLevel::DBG, "loadPackage", "Using cached package: " + name + " " + version);
+                    downloadMetrics->onCacheHit();
+                    content->addPackage(package, apl::JsonData(std::move(cachedPackage)));
+                    continue;
+                }
 
-            auto packageContentFuture =
-                async(std::launch::async, &AplOptionsInterface::downloadResource, aplOptions, source);
-            packageContentByRequestId.insert(std::make_pair(package.getUniqueId(), std::move(packageContentFuture)));
-            packageRequestByRequestId.insert(std::make_pair(package.getUniqueId(), package));
-            count++;
-
-            // if we reach the maximum number of concurrent downloads or already go through all packages, wait for them
-            // to finish
-            if (count % aplOptions->getMaxNumberOfConcurrentDownloads() == 0 || packages.size() == count) {
-                for (auto& kvp : packageContentByRequestId) {
-                    auto packageContent = kvp.second.get();
-                    if (packageContent.empty()) {
-                        aplOptions->logMessage(
-                            LogLevel::ERROR, "renderByAplCoreFailed", "Could not be retrieve requested import");
-                        return false;
+                aplOptions->logMessage(
+                        LogLevel::DBG, "loadPackage", "Requesting package: " + name + " " + version);
+                if (!downloads) {
+                    std::lock_guard<std::mutex> lock{m_packageDownloaderMutex};
+                    if (!m_packageDownloader) {
+                        m_packageDownloader = std::make_shared<AplCorePackageDownloader>(
+                            aplOptions, aplOptions->getMaxNumberOfConcurrentDownloads());
                     }
-                    content->addPackage(packageRequestByRequestId.at(kvp.first), packageContent);
+                    downloader = m_packageDownloader;
+                    downloads = downloader->createBatch();
                 }
-                packageContentByRequestId.clear();
-                packageRequestByRequestId.clear();
+                downloadMetrics->onDownloadStarted();
+                downloads->request(package.getUniqueId(), source);
+                pendingPackages.emplace(
+                    package.getUniqueId(), PendingPackage{package, std::move(key), downloadMetrics});
             }
+            continue;
+        }
+
+        // Add packages in the order their downloads complete
+        uint32_t requestId;
+        std::string packageContent;
+        if (!downloads || !downloads->next(requestId, packageContent)) {
+            break;
+        }
+        auto pendingIt = pendingPackages.find(requestId);
+        if (pendingIt == pendingPackages.end()) {
+            // A download this load did not request, or one already added, has nothing to add
+            aplOptions->logMessage(
+                LogLevel::WARN, "loadPackage", "Ignoring unexpected package download: " + std::to_string(requestId));
+            continue;
+        }
+        auto pending = std::move(pendingIt->second);
+        pendingPackages.erase(pendingIt);
+
+        if (packageContent.empty()) {
+            pending.metrics->onDownloadFailed();
+            aplOptions->logMessage(
+                LogLevel::ERROR, "renderByAplCoreFailed", "Could not be retrieve requested import");
+            return false;
+        }
+        pending.metrics->onDownloadComplete();
+        pending.metrics->onBytesRead(packageContent.size());
+
+        rapidjson::Document parsedPackage;
+        parsedPackage.Parse(packageContent.c_str(), packageContent.size());
+        if (!parsedPackage.HasParseError()) {
+            packageCache->put(pending.key, packageContent, parsedPackage);
         }
+        content->addPackage(pending.request, apl::JsonData(std::move(parsedPackage)));
     }
 
     return !content->isError();
@@ -815,6 +1205,63 @@ bool AplCoreConnectionManager::registerRequestedExtensions() {
     return true;
 }
 
+void AplCoreConnectionManager::premeasureText() {
+    auto textMeasureBatch = std::make_shared<AplCoreTextMeasureBatch>(m_AplCoreMetrics, m_aplConfiguration);
+
+    // Lay the document out once with a measurement which records the requests instead of sending them. The dry run
+    // must not reach the viewhost or the live document, so players and locale methods are created without a
+    // connection, data sources get their own providers and extensions are not bound.
+    apl::RootConfig dryRunConfig = m_RootConfig;
+    dryRunConfig.measure(textMeasureBatch)
+        .localeMethods(std::make_shared<AplCoreLocaleMethods>(nullptr, m_aplConfiguration))
+        .audioPlayerFactory(AplCoreAudioPlayerFactory::create(nullptr, m_aplConfiguration))
+        .mediaPlayerFactory(AplCoreMediaPlayerFactory::create(AplCoreConnectionManagerWPtr(), m_aplConfiguration))
+        .extensionMediator(nullptr);
+    addDataSourceProviders(dryRunConfig);
+
+    auto dryRun = apl::RootContext::create(m_AplCoreMetrics->getMetrics(), m_Content, dryRunConfig);
+    if (!dryRun) {
+        return;
+    }
+    dryRun.reset();
+
+    auto measured = textMeasureBatch->send(*this);
+    m_aplConfiguration->getAplOptions()->logMessage(
+        LogLevel::DBG, __func__, "Premeasured " + std::to_string(measured) + " of " +
+        std::to_string(textMeasureBatch->size()) + " text measurements");
+}
+
+uint64_t AplCoreConnectionManager::getPremeasureHash() const {
+    if (m_documentKey.hash == 0) {
+        return 0;
+    }
+    // The scaling chosen for the build changes the size text is laid out against
+    auto hash = m_documentKey.hash;
+    AplCoreHash::hashBytes(hash, m_buildEnvironment.data(), m_buildEnvironment.size());
+    AplCoreHash::hashScalar(hash, m_AplCoreMetrics->getMetrics().getWidth());
+    AplCoreHash::hashScalar(hash, m_AplCoreMetrics->getMetrics().getHeight());
+    return hash;
+}
+
+/**
+ * Serializes the parts of a build message which determine how a document inflates
+ */
+static std::string getBuildEnvironment(const rapidjson::Value& message) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartArray();
+    for (auto key : BUILD_ENVIRONMENT_KEYS) {
+        auto member = message.FindMember(key);
+        if (member != message.MemberEnd()) {
+            member->value.Accept(writer);
+        } else {
+            writer.Null();
+        }
+    }
+    writer.EndArray();
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
 void AplCoreConnectionManager::handleBuild(const rapidjson::Value& message) {
     auto aplOptions = m_aplConfiguration->getAplOptions();
 
@@ -823,6 +1270,26 @@ void AplCoreConnectionManager::handleBuild(const rapidjson::Value& message) {
             Telemetry::AplRenderingSegment::kRootContextInflation);
     inflationTimer->start();
 
+    auto buildEnvironment = getBuildEnvironment(message);
+    if (m_restoringCachedDocument && buildEnvironment != m_buildEnvironment) {
+        // The document was cached for another viewhost configuration, inflate its prepared content again instead
+        m_Content = m_documentStateToRestore->rootContext->content();
+        m_aplToken = m_documentStateToRestore->token;
+        m_documentStateToRestore.reset();
+    }
+    m_restoringCachedDocument = false;
+
+    if (m_stagedDocument) {
+        // The viewhost was rebuilt, inflate the staged document for it instead, once its content is no longer being
+        // prepared on the staging thread
+        m_stagedDocument->root.wait();
+        m_Content = m_stagedDocument->content;
+        m_aplToken = m_stagedDocument->token;
+        m_documentKey = m_stagedDocument->documentKey;
+        m_liveData = std::move(m_stagedDocument->liveData);
+        m_stagedDocument.reset();
+    }
+
     /* APL Document Inflation started */
     aplOptions->onRenderingEvent(m_aplToken, AplRenderingEvent::INFLATE_BEGIN);
 
@@ -866,6 +1333,7 @@ void AplCoreConnectionManager::handleBuild(const rapidjson::Value& message) {
         int animationQuality =
             getOptionalInt(message, ANIMATIONQUALITY_KEY, apl::RootConfig::AnimationQuality::kAnimationQualityNormal);
 
+        m_textMeasurement = std::make_shared<AplCoreTextMeasurement>(shared_from_this(), m_aplConfiguration);
         m_RootConfig = apl::RootConfig().set({
                          {apl::RootProperty::kAgentName, agentName},
                          {apl::RootProperty::kAgentVersion, agentVersion},
@@ -880,7 +1348,7 @@ void AplCoreConnectionManager::handleBuild(const rapidjson::Value& message) {
                          {apl::RootProperty::kDefaultIdleTimeout, -1},
                          {apl::RootProperty::kDefaultFontFamily, DEFAULT_FONT}
                       })
-                     .measure(std::make_shared<AplCoreTextMeasurement>(shared_from_this(), m_aplConfiguration))
+                     .measure(m_textMeasurement)
                      .localeMethods(std::make_shared<AplCoreLocaleMethods>(shared_from_this(), m_aplConfiguration))
                      .enforceAPLVersion(apl::APLVersion::kAPLVersionIgnore)
                      .enableExperimentalFeature(apl::RootConfig::ExperimentalFeature::kExperimentalFeatureManageMediaRequests)
@@ -888,13 +1356,14 @@ void AplCoreConnectionManager::handleBuild(const rapidjson::Value& message) {
                      .mediaPlayerFactory(m_mediaPlayerFactory);
 
         // Data Sources
-        m_RootConfig.dataSourceProvider(
-            apl::DynamicIndexListConstants::DEFAULT_TYPE_NAME,
-            std::make_shared<apl::DynamicIndexListDataSourceProvider>());
+        addDataSourceProviders(m_RootConfig);
 
-        m_RootConfig.dataSourceProvider(
-                apl::DynamicTokenListConstants::DEFAULT_TYPE_NAME,
-                std::make_shared<apl::DynamicTokenListDataSourceProvider>());
+        m_stagingRootConfig.reset(new apl::RootConfig(m_RootConfig));
+        m_buildEnvironment = buildEnvironment;
+
+        for (const auto& liveObject : m_liveData) {
+            m_RootConfig.liveData(liveObject.first, liveObject.second);
+        }
 
         // Handle metrics data
         m_Metrics.size(message[WIDTH_KEY].GetInt(), message[HEIGHT_KEY].GetInt())
@@ -912,6 +1381,20 @@ void AplCoreConnectionManager::handleBuild(const rapidjson::Value& message) {
         }
     }
 
+    // Whether the viewhost can answer a measureBatch, absent for viewhosts which predate it
+    m_measureBatchSupported = getOptionalBool(message, SUPPORTS_MEASURE_BATCH_KEY, false);
+    // Whether the viewhost can unpack a frameBatch, absent for viewhosts which predate it
+    m_frameBatchSupported = getOptionalBool(message, SUPPORTS_FRAME_BATCH_KEY, false);
+    // Whether the viewhost can replace a live document with a new hierarchy, absent for viewhosts which predate it
+    m_documentSwapSupported = getOptionalBool(message, SUPPORTS_DOCUMENT_SWAP_KEY, false);
+    // Whether the viewhost can apply a hierarchy diff to its components, absent for viewhosts which predate it
+    m_hierarchyDiffSupported = getOptionalBool(message, SUPPORTS_HIERARCHY_DIFF_KEY, false);
+    m_hierarchyDiff.clear();
+    // Whether the viewhost accepts placeholders for off-screen children, and the margin around the viewport in dp
+    // within which children are sent in full, by default one viewport
+    m_virtualizedHierarchySupported = getOptionalBool(message, SUPPORTS_VIRTUALIZED_HIERARCHY_KEY, false);
+    m_virtualizationMargin = getOptionalValue(message, VIRTUALIZATION_MARGIN_KEY, -1.0);
+
     // Extension initialisation
     m_supportedExtensions.clear();
     if (message.HasMember(SUPPORTED_EXTENSIONS) && message[SUPPORTED_EXTENSIONS].IsArray()) {
@@ -991,9 +1474,26 @@ void AplCoreConnectionManager::handleBuild(const rapidjson::Value& message) {
 
             sendViewhostScalingMessage();
 
+            // A document whose last inflation found all of its text in the cache needs no dry run to prime it
+            auto premeasureHash = getPremeasureHash();
+            if (m_measureBatchSupported && !m_premeasuredDocuments.count(premeasureHash)) {
+                premeasureText();
+            }
+
             m_StartTime = getCurrentTime();
+            auto cacheMissCount = m_textMeasurement->getCacheMissCount();
             m_Root = apl::RootContext::create(m_AplCoreMetrics->getMetrics(), m_Content, m_RootConfig);
             if (m_Root) {
+                if (premeasureHash != 0) {
+                    if (m_textMeasurement->getCacheMissCount() == cacheMissCount) {
+                        if (m_premeasuredDocuments.size() >= MAX_PREMEASURED_DOCUMENTS) {
+                            m_premeasuredDocuments.clear();
+                        }
+                        m_premeasuredDocuments.insert(premeasureHash);
+                    } else {
+                        m_premeasuredDocuments.erase(premeasureHash);
+                    }
+                }
                 break;
             } else if (!m_ViewportSizeSpecifications.empty()) {
                 aplOptions->logMessage(
@@ -1048,6 +1548,7 @@ void AplCoreConnectionManager::handleBuild(const rapidjson::Value& message) {
         auto idleTimeout = std::chrono::milliseconds(m_Content->getDocumentSettings()->idleTimeout(m_Root->getRootConfig()));
         aplOptions->onSetDocumentIdleTimeout(m_aplToken, idleTimeout);
         aplOptions->onRenderDocumentComplete(m_aplToken, true, "");
+        cacheDocument();
     } else {
         inflationTimer->fail();
         aplOptions->logMessage(LogLevel::ERROR, "handleBuildFailed", "Unable to inflate document");
@@ -1181,7 +1682,7 @@ void AplCoreConnectionManager::sendDocumentBackgroundMessage(const apl::Object&
 }
 
 void AplCoreConnectionManager::sendScreenLockMessage(bool screenLock) {
-    auto screenLockMsg = AplCoreViewhostMessage(SCREENLOCK_KEY);
+    auto screenLockMsg = AplCoreViewhostMessage(SCREENLOCK_KEY, m_messageArena);
     auto& alloc = screenLockMsg.alloc();
     rapidjson::Value payload(rapidjson::kObjectType);
     payload.AddMember(SCREENLOCK_KEY, screenLock, alloc);
@@ -1609,39 +2110,165 @@ void AplCoreConnectionManager::handleEventResponse(const rapidjson::Value& respo
 }
 
 unsigned int AplCoreConnectionManager::send(AplCoreViewhostMessage& message) {
-    unsigned int seqno = ++m_SequenceNumber;
-    m_aplConfiguration->getAplOptions()->sendMessage(m_aplToken, message.setSequenceNumber(seqno).get());
+    unsigned int seqno;
+    {
+        std::lock_guard<std::mutex> lock{m_frameBatchMutex};
+        seqno = ++m_SequenceNumber;
+        sendWithSequenceNumber(message, seqno);
+    }
+    sendOutbound();
+    return seqno;
+}
+
+void AplCoreConnectionManager::sendWithSequenceNumber(
+        AplCoreViewhostMessage& message,
+        unsigned int seqno,
+        bool immediate) {
+    // Only transferred messages keep the headroom in front of the serialized message, for the host's envelope
+    const auto& serialized = message.setSequenceNumber(seqno).get();
+    const auto headroom = AplCoreViewhostMessageArena::HEADROOM;
+    bool transfer = serialized.size() >= TRANSFER_MESSAGE_SIZE;
+    if (m_frameBatching && !immediate && !transfer) {
+        if (m_frameBatchSize++ > 0) {
+            m_frameBatch += ',';
+        }
+        m_frameBatch.append(serialized, headroom, std::string::npos);
+        return;
+    }
+
+    // Keep the order of the messages batched before this one
+    sendFrameBatch();
+    if (transfer) {
+        m_outbound.push_back({m_aplToken, message.take(), true});
+    } else {
+        m_outbound.push_back({m_aplToken, serialized.substr(headroom), false});
+    }
+}
+
+void AplCoreConnectionManager::sendOutbound() {
+    std::unique_lock<std::mutex> lock{m_frameBatchMutex};
+    auto thisThread = std::this_thread::get_id();
+    if (m_outboundSender != std::thread::id() && m_outboundSender != thisThread) {
+        // The sending thread hands over the messages queued meanwhile, in order
+        return;
+    }
+
+    // A host may send from within sendMessage, such as when it answers a request synchronously. The nested call
+    // continues with the messages queued after the one being sent.
+    auto previousSender = m_outboundSender;
+    m_outboundSender = thisThread;
+    auto aplOptions = m_aplConfiguration->getAplOptions();
+    while (!m_outbound.empty()) {
+        auto outbound = std::move(m_outbound.front());
+        m_outbound.pop_front();
+        lock.unlock();
+        if (outbound.transfer) {
+            aplOptions->transferMessage(outbound.token, std::move(outbound.message));
+        } else {
+            aplOptions->sendMessage(outbound.token, outbound.message);
+        }
+        lock.lock();
+    }
+    m_outboundSender = previousSender;
+}
+
+bool AplCoreConnectionManager::beginFrameBatch() {
+    std::lock_guard<std::mutex> lock{m_frameBatchMutex};
+    if (!m_frameBatchSupported || m_frameBatching) {
+        return false;
+    }
+    m_frameBatching = true;
+    return true;
+}
+
+void AplCoreConnectionManager::flushFrameBatch(bool endBatch) {
+    {
+        std::lock_guard<std::mutex> lock{m_frameBatchMutex};
+        if (endBatch) {
+            m_frameBatching = false;
+        }
+        sendFrameBatch();
+    }
+    sendOutbound();
+}
+
+void AplCoreConnectionManager::sendFrameBatch() {
+    if (m_frameBatchSize == 0) {
+        return;
+    }
+
+    std::string batch;
+    if (m_frameBatchSize > 1) {
+        batch.reserve(m_frameBatch.size() + 32);
+        batch.append("{\"").append(MSG_TYPE_TAG).append("\":\"").append(FRAME_BATCH_KEY);
+        batch.append("\",\"").append(MSG_PAYLOAD_TAG).append("\":[").append(m_frameBatch).append("]}");
+        m_frameBatch.clear();
+    } else {
+        batch.swap(m_frameBatch);
+    }
+    m_outbound.push_back({m_aplToken, std::move(batch), false});
+    m_frameBatchSize = 0;
+}
+
+std::future<AplCoreViewhostInboundMessage> AplCoreConnectionManager::sendRequest(
+        AplCoreViewhostMessage& message,
+        const std::chrono::milliseconds& timeout) {
+    // The reply must be expected before the message is sent, otherwise it could arrive before it can be routed
+    std::future<AplCoreViewhostInboundMessage> future;
+    {
+        std::lock_guard<std::mutex> lock{m_frameBatchMutex};
+        unsigned int seqno = ++m_SequenceNumber;
+        future = m_requestChannel.expect(seqno, AplCoreViewhostRequestChannel::Clock::now() + timeout);
+        sendWithSequenceNumber(message, seqno, true);
+    }
+    sendOutbound();
+    return future;
+}
+
+unsigned int AplCoreConnectionManager::sendRequest(
+        AplCoreViewhostMessage& message,
+        AplCoreViewhostRequestChannel::ReplyCallback callback,
+        const std::chrono::milliseconds& timeout) {
+    unsigned int seqno;
+    {
+        std::lock_guard<std::mutex> lock{m_frameBatchMutex};
+        seqno = ++m_SequenceNumber;
+        m_requestChannel.expect(seqno, AplCoreViewhostRequestChannel::Clock::now() + timeout, std::move(callback));
+        sendWithSequenceNumber(message, seqno, true);
+    }
+    sendOutbound();
     return seqno;
 }
 
 rapidjson::Document AplCoreConnectionManager::blockingSend(
         AplCoreViewhostMessage& message,
         const std::chrono::milliseconds& timeout) {
-    std::lock_guard<std::mutex> lock{m_blockingSendMutex};
-    m_replyPromise = std::promise<std::string>();
-    m_blockingSendReplyExpected = true;
-    // Increment expected sequence number first . While send does increment the sequence number, it calls
-    // sendMessage before returning the incremented number which creates a race condition in shouldHandleMessage
-    m_replyExpectedSequenceNumber = m_SequenceNumber + 1;
-    send(message);
+    unsigned int seqno;
+    std::future<AplCoreViewhostInboundMessage> future;
+    {
+        std::lock_guard<std::mutex> lock{m_frameBatchMutex};
+        seqno = ++m_SequenceNumber;
+        future = m_requestChannel.expect(seqno, AplCoreViewhostRequestChannel::Clock::now() + timeout);
+        sendWithSequenceNumber(message, seqno, true);
+    }
+    sendOutbound();
 
     auto aplOptions = m_aplConfiguration->getAplOptions();
-    auto future = m_replyPromise.get_future();
     auto status = future.wait_for(timeout);
     if (status != std::future_status::ready) {
-        m_blockingSendReplyExpected = false;
+        m_requestChannel.cancel(seqno);
         // Under the situation that finish command destroys the renderer, there is no response.
         aplOptions->logMessage(LogLevel::WARN, "blockingSendFailed", "Did not receive response");
         return rapidjson::Document(rapidjson::kNullType);
     }
 
-    rapidjson::Document doc;
-    if (doc.Parse(future.get()).HasParseError()) {
-        aplOptions->logMessage(LogLevel::ERROR, "blockingSendFailed", "parsingFailed");
+    // The reply was parsed once in shouldHandleMessage, take it over rather than parsing it again
+    auto reply = future.get();
+    if (!reply.isValid()) {
+        aplOptions->logMessage(LogLevel::WARN, "blockingSendFailed", "Did not receive response");
         return rapidjson::Document(rapidjson::kNullType);
     }
-
-    return doc;
+    return reply.toDocument();
 }
 
 void AplCoreConnectionManager::sendError(const std::string& message) {
@@ -1752,7 +2379,7 @@ void AplCoreConnectionManager::processEvent(const apl::Event& event) {
         }
     }
     
-    auto msg = AplCoreViewhostMessage(EVENT_KEY);
+    auto msg = AplCoreViewhostMessage(EVENT_KEY, m_messageArena);
     auto token = send(msg.setPayload(event.serialize(msg.alloc())));
     addPendingEvent(token, event);
 }
@@ -1766,7 +2393,7 @@ bool AplCoreConnectionManager::addPendingEvent(unsigned int token, const apl::Ev
             auto it = m_PendingEvents.find(token);
             if (it != m_PendingEvents.end()) {
                 if (isViewhostEvent) {
-                    auto msg = AplCoreViewhostMessage(EVENT_TERMINATE_KEY);
+                    auto msg = AplCoreViewhostMessage(EVENT_TERMINATE_KEY, m_messageArena);
                     rapidjson::Value payload(rapidjson::kObjectType);
                     payload.AddMember("token", token, msg.alloc());
                     send(msg.setPayload(std::move(payload)));
@@ -1782,12 +2409,29 @@ bool AplCoreConnectionManager::addPendingEvent(unsigned int token, const apl::Ev
     return false;
 }
 
-void AplCoreConnectionManager::sendHierarchy(const std::string& messageKey, bool blocking) {
+void AplCoreConnectionManager::sendHierarchy(const std::string& messageKey, bool blocking, bool allowDiff) {
     if (m_Root) {
-        auto reply = AplCoreViewhostMessage(messageKey);
+        auto reply = AplCoreViewhostMessage(messageKey, m_messageArena);
         rapidjson::Value hierarchy(rapidjson::kObjectType);
-        hierarchy.AddMember("hierarchy", m_Root->topComponent()->serialize(reply.alloc()), reply.alloc());
+        // The viewhost replaces its components, including the placeholders, with their current state
+        m_placeholders.clear();
+        m_virtualizedPagers.clear();
+        m_deferredDirty.clear();
+        auto serialized = serializeComponent(m_Root->topComponent(), reply.alloc());
+        // A virtualized hierarchy is not diffed, its placeholders differ from the components they stand for
+        rapidjson::Value diff;
+        if (m_hierarchyDiffSupported && !m_virtualizedHierarchySupported && allowDiff &&
+            m_hierarchyDiff.diff(serialized, reply.alloc(), diff)) {
+            hierarchy.AddMember("diff", diff, reply.alloc());
+        } else {
+            if (m_hierarchyDiffSupported && !m_virtualizedHierarchySupported) {
+                m_hierarchyDiff.record(serialized);
+            }
+            hierarchy.AddMember("hierarchy", serialized, reply.alloc());
+        }
 
+        // The viewhost rebuilds every component, so it has no displayed children yet
+        m_displayedChildren.clear();
         rapidjson::Value displayedChildrenHierarchy = buildDisplayedChildrenHierarchy(m_Root->topComponent(), reply);
         hierarchy.AddMember("displayedChildrenHierarchy", displayedChildrenHierarchy, reply.alloc());
 
@@ -1805,30 +2449,335 @@ AplCoreConnectionManager::buildDisplayedChildrenHierarchy(const apl::ComponentPt
     std::vector<apl::ComponentPtr> stack;
     stack.push_back(component);
 
+    std::vector<std::string> displayedChildren;
     while(!stack.empty()) {
-        rapidjson::Value displayedChildrenUniqueIds(rapidjson::kArrayType);
         apl::ComponentPtr node = stack.back();
         stack.pop_back();
+        if (m_placeholders.count(node->getUniqueId())) {
+            // The viewhost has no children for a placeholder until it is materialized
+            continue;
+        }
         auto count = node->getDisplayedChildCount();
+        displayedChildren.clear();
+        for (size_t i = 0; i < count; i++) {
+            displayedChildren.push_back(node->getDisplayedChildAt(i)->getUniqueId());
+        }
+
+        auto known = m_displayedChildren.find(node->getUniqueId());
+        if (known != m_displayedChildren.end() && known->second == displayedChildren) {
+            // The viewhost is up to date, and the subtree below changes through its own notifications
+            continue;
+        }
+
+        // Descend only into children which were not displayed before, the others are already known to the viewhost
+        std::unordered_set<std::string> knownChildren;
+        if (known != m_displayedChildren.end()) {
+            knownChildren.insert(known->second.begin(), known->second.end());
+        }
+        rapidjson::Value displayedChildrenUniqueIds(rapidjson::kArrayType);
         for (size_t i = 0; i < count; i++) {
-            auto childComponent = node->getDisplayedChildAt(i);
-            auto str = childComponent->getUniqueId();
+            const auto& str = displayedChildren[i];
             displayedChildrenUniqueIds.PushBack(rapidjson::Value{}.SetString(str.c_str(), str.length(), message.alloc()), message.alloc());
-            stack.push_back(childComponent);
+            if (!knownChildren.count(str)) {
+                stack.push_back(node->getDisplayedChildAt(i));
+            }
         }
         displayedChildrenHierarchy.AddMember(
                 rapidjson::Value{}.SetString(node->getUniqueId().c_str(), node->getUniqueId().length(),message.alloc()),
                 displayedChildrenUniqueIds,
                 message.alloc());
+
+        if (known == m_displayedChildren.end()) {
+            m_displayedChildren.emplace(node->getUniqueId(), displayedChildren);
+        } else {
+            known->second.swap(displayedChildren);
+        }
     }
     return displayedChildrenHierarchy;
 }
 
+rapidjson::Value AplCoreConnectionManager::serializeComponent(
+        const apl::ComponentPtr& component,
+        rapidjson::Document::AllocatorType& allocator) {
+    auto serialized = component->serialize(allocator);
+    if (!m_virtualizedHierarchySupported) {
+        return serialized;
+    }
+
+    auto viewport = m_Root->topComponent()->getGlobalBounds();
+    auto margin = m_virtualizationMargin >= 0 ? static_cast<float>(m_virtualizationMargin)
+                                              : std::max(viewport.getWidth(), viewport.getHeight());
+    viewport = apl::Rect(
+        viewport.getX() - margin, viewport.getY() - margin,
+        viewport.getWidth() + 2 * margin, viewport.getHeight() + 2 * margin);
+    virtualize(component, serialized, viewport, allocator);
+    return serialized;
+}
+
+void AplCoreConnectionManager::virtualize(
+        const apl::ComponentPtr& component,
+        rapidjson::Value& serialized,
+        const apl::Rect& viewport,
+        rapidjson::Document::AllocatorType& allocator) {
+    auto children = serialized.FindMember("children");
+    if (children == serialized.MemberEnd() || !children->value.IsArray()) {
+        return;
+    }
+
+    auto type = component->getType();
+    bool pager = type == apl::kComponentTypePager;
+    bool virtualized = pager || type == apl::kComponentTypeSequence || type == apl::kComponentTypeGridSequence;
+    int currentPage = pager ? component->getCalculated(apl::kPropertyCurrentPage).asInt() : -1;
+
+    auto count = std::min<size_t>(children->value.Size(), component->getChildCount());
+    for (size_t i = 0; i < count; i++) {
+        auto child = component->getChildAt(i);
+        bool inView = !virtualized ||
+                      (pager ? static_cast<int>(i) == currentPage
+                             : !viewport.intersect(child->getGlobalBounds()).empty());
+        auto& serializedChild = children->value[static_cast<rapidjson::SizeType>(i)];
+        if (inView) {
+            virtualize(child, serializedChild, viewport, allocator);
+            continue;
+        }
+
+        // Children laid out away from the viewport, or not laid out yet, are sent with their bounds only
+        rapidjson::Value placeholder(rapidjson::kObjectType);
+        placeholder.AddMember("id", rapidjson::Value(child->getUniqueId().c_str(), allocator), allocator);
+        placeholder.AddMember("type", static_cast<int>(child->getType()), allocator);
+        placeholder.AddMember(PLACEHOLDER_KEY, true, allocator);
+        placeholder.AddMember(
+            BOUNDS_KEY, child->getCalculated(apl::kPropertyBounds).getRect().serialize(allocator), allocator);
+        serializedChild = placeholder;
+
+        m_placeholders.insert(child->getUniqueId());
+        if (pager) {
+            m_virtualizedPagers.insert(component->getUniqueId());
+        }
+    }
+}
+
+bool AplCoreConnectionManager::isInsidePlaceholder(const apl::ComponentPtr& component) {
+    for (auto parent = component->getParent(); parent; parent = parent->getParent()) {
+        if (m_placeholders.count(parent->getUniqueId())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AplCoreConnectionManager::sendMaterialized(const std::vector<std::string>& uniqueIds) {
+    auto reply = AplCoreViewhostMessage(MATERIALIZE_KEY, m_messageArena);
+    rapidjson::Value components(rapidjson::kArrayType);
+    for (const auto& uniqueId : uniqueIds) {
+        if (!m_placeholders.erase(uniqueId)) {
+            continue;
+        }
+        auto component = m_Root->findComponentById(uniqueId);
+        if (!component) {
+            continue;
+        }
+        auto serialized = serializeComponent(component, reply.alloc());
+        serialized.AddMember(
+            "displayedChildrenHierarchy", buildDisplayedChildrenHierarchy(component, reply), reply.alloc());
+        components.PushBack(serialized, reply.alloc());
+    }
+
+    if (components.Empty()) {
+        return;
+    }
+    rapidjson::Value payload(rapidjson::kObjectType);
+    payload.AddMember(COMPONENTS_KEY, components, reply.alloc());
+    send(reply.setPayload(std::move(payload)));
+}
+
+void AplCoreConnectionManager::handleMaterialize(const rapidjson::Value& payload) {
+    if (!m_Root) {
+        m_aplConfiguration->getAplOptions()->logMessage(
+            LogLevel::ERROR, "handleMaterializeFailed", "Root context is null");
+        return;
+    }
+
+    std::vector<std::string> uniqueIds;
+    if (payload.HasMember(COMPONENTS_KEY) && payload[COMPONENTS_KEY].IsArray()) {
+        for (auto& uniqueId : payload[COMPONENTS_KEY].GetArray()) {
+            if (uniqueId.IsString()) {
+                uniqueIds.emplace_back(uniqueId.GetString());
+            }
+        }
+    }
+    sendMaterialized(uniqueIds);
+}
+
+void AplCoreConnectionManager::prefetchPagerPages() {
+    for (auto it = m_virtualizedPagers.begin(); it != m_virtualizedPagers.end();) {
+        auto pager = m_Root->findComponentById(*it);
+        if (!pager) {
+            it = m_virtualizedPagers.erase(it);
+            continue;
+        }
+
+        // The current page first, in case the pager moved onto a placeholder, then the next one
+        auto currentPage = pager->getCalculated(apl::kPropertyCurrentPage).asInt();
+        auto pageCount = static_cast<int>(pager->getChildCount());
+        for (int page = std::max(currentPage, 0); page <= currentPage + 1 && page < pageCount; page++) {
+            auto uniqueId = pager->getChildAt(page)->getUniqueId();
+            if (m_placeholders.count(uniqueId)) {
+                // One page per idle frame, and another frame to look for the next
+                sendMaterialized({uniqueId});
+                m_tickRequested = true;
+                return;
+            }
+        }
+
+        bool hasPlaceholders = false;
+        for (int page = 0; page < pageCount && !hasPlaceholders; page++) {
+            hasPlaceholders = m_placeholders.count(pager->getChildAt(page)->getUniqueId()) > 0;
+        }
+        if (hasPlaceholders) {
+            ++it;
+        } else {
+            it = m_virtualizedPagers.erase(it);
+        }
+    }
+}
+
+void AplCoreConnectionManager::forgetDisplayedChildren(const std::string& uniqueId) {
+    std::vector<std::string> stack{uniqueId};
+    while (!stack.empty()) {
+        auto known = m_displayedChildren.find(stack.back());
+        stack.pop_back();
+        if (known != m_displayedChildren.end()) {
+            stack.insert(stack.end(), known->second.begin(), known->second.end());
+            m_displayedChildren.erase(known);
+        }
+    }
+}
+
+bool AplCoreConnectionManager::isDisplayed(const apl::ComponentPtr& component) {
+    if (component->getCalculated(apl::kPropertyDisplay).asInt() != apl::kDisplayNormal) {
+        return false;
+    }
+    auto parent = component->getParent();
+    if (!parent) {
+        return true;
+    }
+    // The displayed children leave out those scrolled out of view, the pages not shown and the invisible ones. They
+    // are gathered once per parent and frame, as the components of a frame often share their parents.
+    auto displayedChildren = m_frameDisplayedChildren.find(parent->getUniqueId());
+    if (displayedChildren == m_frameDisplayedChildren.end()) {
+        std::unordered_set<std::string> uniqueIds;
+        auto count = parent->getDisplayedChildCount();
+        uniqueIds.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            uniqueIds.insert(parent->getDisplayedChildAt(i)->getUniqueId());
+        }
+        displayedChildren = m_frameDisplayedChildren.emplace(parent->getUniqueId(), std::move(uniqueIds)).first;
+    }
+    return displayedChildren->second.count(component->getUniqueId()) > 0;
+}
+
+bool AplCoreConnectionManager::isShown(const apl::ComponentPtr& component) {
+    auto shown = m_frameShown.find(component->getUniqueId());
+    if (shown != m_frameShown.end()) {
+        return shown->second;
+    }
+    auto parent = component->getParent();
+    bool result = isDisplayed(component) && (!parent || isShown(parent));
+    m_frameShown.emplace(component->getUniqueId(), result);
+    return result;
+}
+
+bool AplCoreConnectionManager::deferDirty(const apl::ComponentPtr& component) {
+    const auto& dirty = component->getDirty();
+    if (dirty.count(apl::kPropertyNotifyChildrenChanged) || dirty.count(apl::kPropertyGraphic)) {
+        // Structural changes are always sent
+        return false;
+    }
+
+    auto parent = component->getParent();
+    if (!parent || isShown(parent)) {
+        if (isDisplayed(component)) {
+            return false;
+        }
+        // The component hid itself, or may have, so the viewhost needs the change which hid it
+        for (auto key : VISIBILITY_PROPERTIES) {
+            if (dirty.count(key)) {
+                return false;
+            }
+        }
+    }
+
+    auto& deferred = m_deferredDirty[component->getUniqueId()];
+    deferred.component = component;
+    deferred.properties.insert(dirty.begin(), dirty.end());
+    return true;
+}
+
+void AplCoreConnectionManager::flushDeferredDirty(
+        std::map<std::string, rapidjson::Value>& updates,
+        AplCoreViewhostMessage& message) {
+    for (auto it = m_deferredDirty.begin(); it != m_deferredDirty.end();) {
+        auto component = it->second.component.lock();
+        if (!component || (!m_placeholders.empty() && isInsidePlaceholder(component))) {
+            it = m_deferredDirty.erase(it);
+            continue;
+        }
+
+        if (!isShown(component)) {
+            ++it;
+            continue;
+        }
+
+        // Send the current value of every property which changed while the component was held
+        if (!m_hierarchyDiff.empty()) {
+            m_hierarchyDiff.invalidate(it->first);
+        }
+        auto& update = updates[it->first];
+        if (!update.IsObject()) {
+            update.SetObject();
+            update.AddMember("id", rapidjson::Value(it->first.c_str(), message.alloc()), message.alloc());
+        }
+        for (auto key : it->second.properties) {
+            const auto& name = apl::sComponentPropertyBimap.at(key);
+            if (!update.HasMember(name.c_str())) {
+                update.AddMember(
+                    rapidjson::Value(name.c_str(), message.alloc()),
+                    component->getCalculated(key).serialize(message.alloc()),
+                    message.alloc());
+            }
+        }
+        it = m_deferredDirty.erase(it);
+    }
+}
+
 void AplCoreConnectionManager::processDirty(const std::set<apl::ComponentPtr>& dirty) {
     std::map<std::string, rapidjson::Value> tempDirty;
-    auto msg = AplCoreViewhostMessage(DIRTY_KEY);
+    auto msg = AplCoreViewhostMessage(DIRTY_KEY, m_messageArena);
 
     for (auto& component : dirty) {
+        if (!m_placeholders.empty()) {
+            if (isInsidePlaceholder(component)) {
+                // The viewhost does not have the component, it is serialized in full when materialized
+                continue;
+            }
+            if (m_virtualizedPagers.count(component->getUniqueId()) &&
+                component->getDirty().count(apl::kPropertyCurrentPage)) {
+                // Prefetch around the new page on the next idle frame
+                m_tickRequested = true;
+            }
+        }
+        if (deferDirty(component)) {
+            continue;
+        }
+        // Keep the hierarchy fingerprint consistent with the components the viewhost now has
+        if (!m_hierarchyDiff.empty()) {
+            if (component->getDirty().count(apl::kPropertyNotifyChildrenChanged)) {
+                m_hierarchyDiff.clear();
+            } else {
+                m_hierarchyDiff.invalidate(component->getUniqueId());
+            }
+        }
         if (component->getDirty().count(apl::kPropertyNotifyChildrenChanged)) {
             auto notify = component->getCalculated(apl::kPropertyNotifyChildrenChanged);
             const auto& changed = notify.getArray();
@@ -1840,19 +2789,23 @@ void AplCoreConnectionManager::processDirty(const std::set<apl::ComponentPtr>& d
                 auto newChildId = changed.at(i).get("uid").asString();
                 auto newChildIndex = changed.at(i).get("index").asInt();
                 auto action = changed.at(i).get("action").asString();
-                if (action == "insert") {
+                if (action == "remove") {
+                    forgetDisplayedChildren(newChildId);
+                } else if (action == "insert") {
                     auto newComponent = component->getChildAt(newChildIndex);
-                    rapidjson::Value newComponentHierarchy = newComponent->serialize(msg.alloc());
+                    rapidjson::Value newComponentHierarchy = serializeComponent(newComponent, msg.alloc());
                     rapidjson::Value displayedChildrenHierarchy = buildDisplayedChildrenHierarchy(newComponent, msg);
                     newComponentHierarchy.AddMember("displayedChildrenHierarchy", displayedChildrenHierarchy, msg.alloc());
                     tempDirty[newChildId] = newComponentHierarchy;
                 }
             }
             if (tempDirty.find(component->getUniqueId()) == tempDirty.end()) {
-                // notify children change needs to update displayed children ids
+                // notify children change needs to update displayed children ids, for the components where they changed
                 rapidjson::Value dirtyWithChildChange = component->serializeDirty(msg.alloc());
                 rapidjson::Value displayedChildrenHierarchy = buildDisplayedChildrenHierarchy(component, msg);
-                dirtyWithChildChange.AddMember("displayedChildrenHierarchy", displayedChildrenHierarchy, msg.alloc());
+                if (displayedChildrenHierarchy.MemberCount() > 0) {
+                    dirtyWithChildChange.AddMember("displayedChildrenHierarchy", displayedChildrenHierarchy, msg.alloc());
+                }
                 tempDirty[component->getUniqueId()] = dirtyWithChildChange;
             }
         }
@@ -1883,6 +2836,14 @@ void AplCoreConnectionManager::processDirty(const std::set<apl::ComponentPtr>& d
         }
     }
 
+    // Anything in this frame may have brought held components into view
+    flushDeferredDirty(tempDirty, msg);
+    m_frameDisplayedChildren.clear();
+    m_frameShown.clear();
+    if (tempDirty.empty()) {
+        return;
+    }
+
     rapidjson::Value array(rapidjson::kArrayType);
     for (auto rit = tempDirty.rbegin(); rit != tempDirty.rend(); rit++) {
         auto uid = rit->first;
@@ -1899,13 +2860,18 @@ void AplCoreConnectionManager::coreFrameUpdate() {
         aplOptions->logMessage(LogLevel::ERROR, "coreFrameUpdateFailed", "Root context is null");
         return;
     }
+    // Gather the messages of this update into one frame batch, unless this update is nested in another
+    bool frameBatch = beginFrameBatch();
+
     auto now = getCurrentTime() - m_StartTime;
     m_Root->updateTime(now.count(), getCurrentTime().count());
     m_Root->setLocalTimeAdjustment(aplOptions->getTimezoneOffset().count());
+    applyCoalescedInput();
     std::dynamic_pointer_cast<AplCoreAudioPlayerFactory>(m_Root->getRootConfig().getAudioPlayerFactory())->tick(*this);
 
     m_Root->clearPending();
 
+    bool idle = !m_Root->hasEvent() && !m_Root->isDirty();
     while (m_Root->hasEvent()) {
         processEvent(m_Root->popEvent());
     }
@@ -1915,10 +2881,25 @@ void AplCoreConnectionManager::coreFrameUpdate() {
         m_Root->clearDirty();
     }
 
+    if (idle && !m_virtualizedPagers.empty()) {
+        prefetchPagerPages();
+    }
+
     handleScreenLock();
+
+    if (frameBatch) {
+        flushFrameBatch(true);
+    }
 }
 
 void AplCoreConnectionManager::onUpdateTick() {
+    m_tickRequested = false;
+
+    // Fail any requests the viewhost did not answer in time
+    m_requestChannel.expire(AplCoreViewhostRequestChannel::Clock::now());
+
+    swapStagedDocument();
+
     if (m_Root) {
         coreFrameUpdate();
         // Check regularly as something like timed-out fetch requests could come up.
@@ -1926,6 +2907,38 @@ void AplCoreConnectionManager::onUpdateTick() {
     }
 }
 
+std::chrono::steady_clock::time_point AplCoreConnectionManager::getNextTickTime() {
+    auto now = std::chrono::steady_clock::now();
+    auto next = m_requestChannel.nextDeadline();
+    if (m_stagedDocument) {
+        next = std::min(next, now + STAGED_DOCUMENT_POLL_INTERVAL);
+    }
+    if (!m_Root) {
+        return next;
+    }
+
+    if (m_tickRequested || m_Root->hasEvent() || m_Root->isDirty()) {
+        return now;
+    }
+
+    // Playing audio reports its progress to core every tick
+    auto audioFactory =
+        std::dynamic_pointer_cast<AplCoreAudioPlayerFactory>(m_Root->getRootConfig().getAudioPlayerFactory());
+    if (audioFactory && audioFactory->hasPlayingPlayers()) {
+        return now;
+    }
+
+    // Core timers drive commands, animations and data source timeouts
+    auto delay = m_Root->nextTime() - (getCurrentTime() - m_StartTime).count();
+    if (delay <= 0) {
+        return now;
+    }
+    if (delay < MAX_TIMER_DELAY.count()) {
+        next = std::min(next, now + std::chrono::milliseconds(static_cast<long long>(std::ceil(delay))));
+    }
+    return next;
+}
+
 apl::Rect AplCoreConnectionManager::convertJsonToScaledRect(const rapidjson::Value& jsonNode) {
     const float scale = m_AplCoreMetrics->toCore(1.0f);
     const float x = jsonNode[X_KEY].IsNumber() ? jsonNode[X_KEY].GetFloat() : 0.0f;
@@ -2017,6 +3030,16 @@ alexaext::ExtensionPtr AplCoreConnectionManager::getAlexaExtExtension(const std:
 }
 
 void AplCoreConnectionManager::reset() {
+    m_stagedDocument.reset();
+    m_documentKey.clear();
+    m_liveData.clear();
+    m_displayedChildren.clear();
+    m_hierarchyDiff.clear();
+    m_placeholders.clear();
+    m_virtualizedPagers.clear();
+    m_deferredDirty.clear();
+    m_inputCoalescer.clear();
+    m_restoringCachedDocument = false;
     m_aplToken = "";
     m_Root.reset();
     m_Content.reset();
@@ -2107,13 +3130,13 @@ void AplCoreConnectionManager::handleReInflate(const rapidjson::Value& payload)
 
     m_Root->reinflate();
 
-    // update component hierarchy
-    sendHierarchy(HIERARCHY_KEY);
+    // update component hierarchy, most of which is usually unchanged by a reinflate
+    sendHierarchy(HIERARCHY_KEY, false, true);
 }
 
 void AplCoreConnectionManager::handleReHierarchy(const rapidjson::Value& payload) {
     // send component hierarchy
-    sendHierarchy(REHIERARCHY_KEY, true);
+    sendHierarchy(REHIERARCHY_KEY, true, true);
 }
 
 void AplCoreConnectionManager::updateConfigurationChange(const apl::ConfigurationChange& configurationChange) {
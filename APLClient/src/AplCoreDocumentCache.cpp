@@ -0,0 +1,140 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "APLClient/AplCoreDocumentCache.h"
+#include "APLClient/AplCoreHash.h"
+
+namespace APLClient {
+
+/**
+ * Adds a string to the inputs of a key, preceded by its length so that consecutive strings cannot run into each other
+ */
+static void appendString(std::string& inputs, const std::string& value) {
+    inputs.append(std::to_string(value.size())).append(1, ':').append(value);
+}
+
+/**
+ * Adds a string to a hash as @c appendString adds it to the inputs, without building the inputs
+ */
+static void hashString(uint64_t& hash, const std::string& value) {
+    auto size = std::to_string(value.size());
+    AplCoreHash::hashBytes(hash, size.data(), size.size());
+    AplCoreHash::hashBytes(hash, ":", 1);
+    AplCoreHash::hashBytes(hash, value.data(), value.size());
+}
+
+AplCoreDocumentCache::AplCoreDocumentCache(size_t maxEntries) : m_maxEntries{maxEntries} {
+}
+
+AplCoreDocumentCache::Key AplCoreDocumentCache::makeDocumentKey(
+        const std::string& document,
+        const std::string& data,
+        const std::string& supportedViewports) {
+    auto inputs = std::make_shared<std::string>();
+    inputs->reserve(document.size() + data.size() + supportedViewports.size() + 32);
+    appendString(*inputs, document);
+    appendString(*inputs, data);
+    appendString(*inputs, supportedViewports);
+
+    Key key;
+    key.hash = AplCoreHash::hash(inputs->data(), inputs->size());
+    key.inputs = std::move(inputs);
+    return key;
+}
+
+AplCoreDocumentCache::Key AplCoreDocumentCache::makeUncachedDocumentKey(
+        const std::string& document,
+        const std::string& data,
+        const std::string& supportedViewports) {
+    Key key;
+    key.hash = AplCoreHash::OFFSET_BASIS;
+    hashString(key.hash, document);
+    hashString(key.hash, data);
+    hashString(key.hash, supportedViewports);
+    return key;
+}
+
+void AplCoreDocumentCache::setMaxEntries(size_t maxEntries) {
+    m_maxEntries = maxEntries;
+    trim();
+}
+
+Extensions::AplDocumentStatePtr AplCoreDocumentCache::get(const Key& key, const std::string& environment) {
+    auto it = find(key, environment);
+    if (it == m_index.end()) {
+        return nullptr;
+    }
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->documentState;
+}
+
+void AplCoreDocumentCache::put(
+        const Key& key,
+        const std::string& environment,
+        Extensions::AplDocumentStatePtr documentState) {
+    if (!isEnabled() || key.empty()) {
+        return;
+    }
+    auto hash = indexHash(key, environment);
+    auto it = m_index.find(hash);
+    if (it != m_index.end()) {
+        m_entries.erase(it->second);
+    }
+    m_entries.push_front(Entry{key, environment, std::move(documentState)});
+    m_index[hash] = m_entries.begin();
+    trim();
+}
+
+void AplCoreDocumentCache::erase(const Key& key, const std::string& environment) {
+    auto it = find(key, environment);
+    if (it != m_index.end()) {
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+}
+
+void AplCoreDocumentCache::clear() {
+    m_entries.clear();
+    m_index.clear();
+}
+
+uint64_t AplCoreDocumentCache::indexHash(const Key& key, const std::string& environment) {
+    auto hash = key.hash;
+    AplCoreHash::hashBytes(hash, environment.data(), environment.size());
+    return hash;
+}
+
+std::unordered_map<uint64_t, AplCoreDocumentCache::LruList::iterator>::iterator AplCoreDocumentCache::find(
+        const Key& key,
+        const std::string& environment) {
+    if (key.empty()) {
+        return m_index.end();
+    }
+    auto it = m_index.find(indexHash(key, environment));
+    // A document of other inputs whose hash is the same is a miss
+    if (it == m_index.end() || it->second->key != key || it->second->environment != environment) {
+        return m_index.end();
+    }
+    return it;
+}
+
+void AplCoreDocumentCache::trim() {
+    while (m_entries.size() > m_maxEntries) {
+        m_index.erase(indexHash(m_entries.back().key, m_entries.back().environment));
+        m_entries.pop_back();
+    }
+}
+
+}  // namespace APLClient
@@ -13,6 +13,7 @@
  * permissions and limitations under the License.
  */
 #include <fstream>
+#include <thread>
 
 #include <rapidjson/document.h>
 
@@ -24,14 +25,108 @@ namespace APLClient {
 static const std::string DEFAULT_PARAM_BINDING = "payload";
 /// Default string to attach to mainTemplate parameters.
 static const std::string DEFAULT_PARAM_VALUE = "{}";
+/// Separates the client id from the skill id in a presentation token
+static const std::string TOKEN_SCOPE_DELIMITER = "#TID#";
+
+/**
+ * The scope of a presentation token, which is its client and skill id. Tokens without a skill id are their own scope.
+ */
+static std::string getTokenScope(const std::string& token) {
+    auto delimiterPosition = token.find(TOKEN_SCOPE_DELIMITER);
+    if (delimiterPosition == std::string::npos) {
+        return token;
+    }
+    return token.substr(0, token.find(':', delimiterPosition + TOKEN_SCOPE_DELIMITER.length()));
+}
+
+/**
+ * Copies the value a mainTemplate parameter is bound to, following the rules of @c AplCoreGuiRenderer::bindData
+ */
+static void getParameterValue(const std::string& name, const rapidjson::Value& sources, rapidjson::Document& value) {
+    rapidjson::Value::ConstMemberIterator source;
+    if (name == DEFAULT_PARAM_BINDING) {
+        value.CopyFrom(sources, value.GetAllocator());
+    } else if (sources.IsObject() && (source = sources.FindMember(name.c_str())) != sources.MemberEnd()) {
+        value.CopyFrom(source->value, value.GetAllocator());
+    } else {
+        value.SetObject();
+    }
+}
+
+/**
+ * @return true if the value is or holds an array
+ */
+static bool containsArray(const rapidjson::Value& value) {
+    if (value.IsArray()) {
+        return true;
+    }
+    if (value.IsObject()) {
+        for (const auto& member : value.GetObject()) {
+            if (containsArray(member.value)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Checks whether a live data value can change in place. Arrays may feed the data of multi-child components, which
+ * core does not inflate again when their live data changes, so any change to an array needs a new document.
+ */
+static bool canUpdateLive(const rapidjson::Value& current, const rapidjson::Value& next) {
+    if (current.IsObject() && next.IsObject()) {
+        for (const auto& member : current.GetObject()) {
+            auto nextMember = next.FindMember(member.name);
+            if (nextMember == next.MemberEnd() ? containsArray(member.value)
+                                               : !canUpdateLive(member.value, nextMember->value)) {
+                return false;
+            }
+        }
+        for (const auto& member : next.GetObject()) {
+            if (!current.HasMember(member.name) && containsArray(member.value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (current.IsArray() || next.IsArray()) {
+        return current == next;
+    }
+    return true;
+}
+
+/**
+ * Copies a JSON value into an object which owns it
+ */
+static apl::Object toObject(const rapidjson::Value& value) {
+    rapidjson::Document document;
+    document.CopyFrom(value, document.GetAllocator());
+    return apl::Object(std::move(document));
+}
 
 AplCoreGuiRenderer::AplCoreGuiRenderer(AplConfigurationPtr config, AplCoreConnectionManagerPtr aplCoreConnectionManager)
         : m_aplConfiguration{config},
           m_aplCoreConnectionManager{aplCoreConnectionManager},
-          m_isDocumentCleared{false} {
+          m_isDocumentCleared{false},
+          m_prefetchGeneration{0},
+          m_prefetchStopping{false},
+          m_dataOnlyRenderEnabled{false} {
 
 }
 
+AplCoreGuiRenderer::~AplCoreGuiRenderer() {
+    {
+        std::lock_guard<std::mutex> lock{m_prefetchMutex};
+        m_prefetchStopping = true;
+        m_prefetchGeneration++;
+    }
+    m_prefetchCondition.notify_one();
+    if (m_prefetchThread.joinable()) {
+        m_prefetchThread.join();
+    }
+}
+
 void AplCoreGuiRenderer::executeCommands(const std::string& jsonPayload, const std::string& token) {
     m_aplCoreConnectionManager->executeCommands(jsonPayload, token);
 }
@@ -49,6 +144,81 @@ void AplCoreGuiRenderer::interruptCommandSequence() {
 
 void AplCoreGuiRenderer::setViewhostConfig(const AplViewhostConfigPtr& config) {
     m_aplCoreConnectionManager->updateViewhostConfig(config);
+
+    // Content prefetched for the previous viewport may have resolved different imports
+    std::future<apl::ContentPtr> superseded;
+    std::lock_guard<std::mutex> lock{m_prefetchMutex};
+    superseded = std::move(m_prefetchContent);
+    m_prefetchRequest.reset();
+    m_prefetchGeneration++;
+}
+
+void AplCoreGuiRenderer::prefetchDocument(const std::string& document, const std::string& data) {
+    std::unique_ptr<PrefetchRequest> request{new PrefetchRequest()};
+    request->document = document;
+    request->data = data;
+    request->metrics = m_aplCoreConnectionManager->getMetrics();
+    request->rootConfig = m_aplCoreConnectionManager->getRootConfig();
+    auto prefetchContent = request->content.get_future();
+
+    {
+        // Dropping a superseded prefetch does not wait for it, the prefetch thread discards it
+        std::lock_guard<std::mutex> lock{m_prefetchMutex};
+        m_prefetchDocument = document;
+        m_prefetchData = data;
+        std::swap(m_prefetchContent, prefetchContent);
+        m_prefetchRequest = std::move(request);
+        m_prefetchGeneration++;
+        if (!m_prefetchThread.joinable()) {
+            m_prefetchThread = std::thread(&AplCoreGuiRenderer::runPrefetches, this);
+        }
+    }
+    m_prefetchCondition.notify_one();
+}
+
+void AplCoreGuiRenderer::runPrefetches() {
+    std::unique_lock<std::mutex> lock{m_prefetchMutex};
+    while (true) {
+        m_prefetchCondition.wait(lock, [this]() { return m_prefetchStopping || m_prefetchRequest; });
+        if (m_prefetchStopping) {
+            return;
+        }
+        auto request = std::move(m_prefetchRequest);
+        uint64_t generation = m_prefetchGeneration;
+        lock.unlock();
+
+        // A superseded prefetch stops at its next step, its content is no longer wanted
+        apl::ContentPtr content;
+        if (!isPrefetchSuperseded(generation)) {
+            content = apl::Content::create(
+                apl::JsonData(request->document), apl::makeDefaultSession(), request->metrics, request->rootConfig);
+        }
+        if (content) {
+            bindData(content, apl::JsonData(request->data));
+            if (isPrefetchSuperseded(generation) || !m_aplCoreConnectionManager->loadPackage(content) ||
+                !content->isReady()) {
+                content = nullptr;
+            }
+        }
+        request->content.set_value(content);
+        request.reset();
+
+        lock.lock();
+    }
+}
+
+apl::ContentPtr AplCoreGuiRenderer::takePrefetchedContent(const std::string& document, const std::string& data) {
+    std::future<apl::ContentPtr> prefetchContent;
+    {
+        std::lock_guard<std::mutex> lock{m_prefetchMutex};
+        if (!m_prefetchContent.valid() || m_prefetchDocument != document || m_prefetchData != data) {
+            return nullptr;
+        }
+        prefetchContent = std::move(m_prefetchContent);
+        m_prefetchDocument.clear();
+        m_prefetchData.clear();
+    }
+    return prefetchContent.get();
 }
 
 void AplCoreGuiRenderer::renderDocument(
@@ -56,8 +226,86 @@ void AplCoreGuiRenderer::renderDocument(
     const std::string& data,
     const std::string& supportedViewports,
     const std::string& token) {
+    if (m_dataOnlyRenderEnabled && renderDataOnly(document, data, token)) {
+        m_aplConfiguration->getAplOptions()->logMessage(LogLevel::DBG, __func__, "Applied data to live document");
+        return;
+    }
+    clearLiveDocument();
+
+    AplCoreDocumentCache::Key documentKey;
+    if (m_aplCoreConnectionManager->isDocumentCacheEnabled()) {
+        documentKey = AplCoreDocumentCache::makeDocumentKey(document, data, supportedViewports);
+        if (m_aplCoreConnectionManager->restoreCachedDocument(documentKey, token)) {
+            m_isDocumentCleared = false;
+            m_aplCoreConnectionManager->setSupportedViewports(supportedViewports);
+            return;
+        }
+    } else {
+        documentKey = AplCoreDocumentCache::makeUncachedDocumentKey(document, data, supportedViewports);
+    }
+
     m_isDocumentCleared = false;
+    auto content = takePrefetchedContent(document, data);
+    if (content) {
+        m_aplConfiguration->getAplOptions()->logMessage(LogLevel::DBG, __func__, "Using prefetched content");
+        m_aplConfiguration->getMetricsRecorder()->flush();
+        m_aplCoreConnectionManager->setSupportedViewports(supportedViewports);
+        m_aplCoreConnectionManager->prepareContent(documentKey, {});
+        m_aplCoreConnectionManager->setContent(content, token);
+        return;
+    }
 
+    rapidjson::Document parsedDocument;
+    rapidjson::Document parsedData;
+    AplCoreConnectionManager::LiveDataMap liveData;
+    if (m_dataOnlyRenderEnabled) {
+        parsedDocument.Parse(document.c_str(), document.size());
+        parsedData.Parse(data.c_str(), data.size());
+        if (!parsedDocument.HasParseError() && !parsedData.HasParseError()) {
+            liveData = bindLiveParameters(parsedDocument, parsedData);
+        }
+    }
+
+    if (liveData.empty()) {
+        content = createContent(apl::JsonData(document), apl::JsonData(data), token);
+    } else {
+        content = createContent(apl::JsonData(std::move(parsedDocument)), apl::JsonData(std::move(parsedData)), token);
+    }
+    if (content && !m_isDocumentCleared) {
+        if (!liveData.empty()) {
+            m_liveContent = content;
+            m_liveDocument = document;
+            m_liveTokenScope = getTokenScope(token);
+        }
+        m_aplCoreConnectionManager->setSupportedViewports(supportedViewports);
+        m_aplCoreConnectionManager->prepareContent(documentKey, std::move(liveData));
+        m_aplCoreConnectionManager->setContent(content, token);
+    }
+}
+
+void AplCoreGuiRenderer::renderDocument(
+    apl::JsonData&& document,
+    apl::JsonData&& data,
+    const std::string& supportedViewports,
+    const std::string& token) {
+    clearLiveDocument();
+    m_isDocumentCleared = false;
+
+    auto content = createContent(std::move(document), std::move(data), token);
+    if (content && !m_isDocumentCleared) {
+        /**
+         *  Only set the content if we haven't been cleared while building.
+         */
+        m_aplCoreConnectionManager->setSupportedViewports(supportedViewports);
+        m_aplCoreConnectionManager->prepareContent(AplCoreDocumentCache::Key(), {});
+        m_aplCoreConnectionManager->setContent(content, token);
+    }
+}
+
+apl::ContentPtr AplCoreGuiRenderer::createContent(
+    apl::JsonData&& document,
+    apl::JsonData&& data,
+    const std::string& token) {
     auto metricsRecorder = m_aplConfiguration->getMetricsRecorder();
     auto aplOptions = m_aplConfiguration->getAplOptions();
     auto tContentCreate = metricsRecorder->createTimer(
@@ -79,33 +327,16 @@ void AplCoreGuiRenderer::renderDocument(
 
         tContentCreate->fail();
         aplOptions->onRenderDocumentComplete(token, false, "Unable to create content");
-        return;
+        return nullptr;
     }
 
-    std::map<std::string, apl::JsonData> params;
-    apl::JsonData sourcesData(data);
-    if (sourcesData.get().IsObject()) {
-        for (auto objIt = sourcesData.get().MemberBegin(); objIt != sourcesData.get().MemberEnd(); objIt++) {
-            params.emplace(objIt->name.GetString(), objIt->value);
-        }
-    }
-
-    for (size_t idx = 0; idx < content->getParameterCount(); idx++) {
-        auto parameterName = content->getParameterAt(idx);
-        if (parameterName == DEFAULT_PARAM_BINDING) {
-            content->addData(parameterName, data);
-        } else if (params.find(parameterName) != params.end()) {
-            content->addData(parameterName, params.at(parameterName).toString());
-        } else {
-            content->addData(parameterName, DEFAULT_PARAM_VALUE);
-        }
-    }
+    bindData(content, std::move(data));
 
     if (!m_aplCoreConnectionManager->loadPackage(content)) {
         aplOptions->onRenderDocumentComplete(token, false, "Unresolved import");
         tContentCreate->fail();
         cError->increment();
-        return;
+        return nullptr;
     }
 
     if (!content->isReady()) {
@@ -113,23 +344,161 @@ void AplCoreGuiRenderer::renderDocument(
 
         aplOptions->onRenderDocumentComplete(token, false, "Content is not ready");
         tContentCreate->fail();
-        return;
+        return nullptr;
     }
 
     tContentCreate->stop();
     metricsRecorder->flush();
+    return content;
+}
 
-    if (!m_isDocumentCleared) {
-        /**
-         *  Only set the content if we haven't been cleared while building.
-         */
-        m_aplCoreConnectionManager->setSupportedViewports(supportedViewports);
-        m_aplCoreConnectionManager->setContent(content, token);
+AplCoreConnectionManager::LiveDataMap AplCoreGuiRenderer::bindLiveParameters(
+    rapidjson::Document& document,
+    const rapidjson::Value& sources) {
+    AplCoreConnectionManager::LiveDataMap liveData;
+    if (!document.IsObject()) {
+        return liveData;
+    }
+    auto mainTemplate = document.FindMember("mainTemplate");
+    if (mainTemplate == document.MemberEnd() || !mainTemplate->value.IsObject()) {
+        return liveData;
+    }
+    auto parameters = mainTemplate->value.FindMember("parameters");
+    if (parameters == mainTemplate->value.MemberEnd() || !parameters->value.IsArray()) {
+        return liveData;
+    }
+
+    // Parameters bound to objects become live maps, which the document sees under the same name once the parameter
+    // is removed from the mainTemplate. The values of the others are kept, as they can only change with a new render.
+    auto& names = parameters->value;
+    for (auto name = names.Begin(); name != names.End();) {
+        if (!name->IsString()) {
+            // A declaration with a type or default value is bound as is
+            if (name->IsObject()) {
+                auto declaredName = name->FindMember("name");
+                if (declaredName != name->MemberEnd() && declaredName->value.IsString()) {
+                    std::string parameterName = declaredName->value.GetString();
+                    getParameterValue(parameterName, sources, m_staticParameters[parameterName]);
+                }
+            }
+            ++name;
+            continue;
+        }
+        LiveParameter parameter;
+        getParameterValue(name->GetString(), sources, parameter.value);
+        if (!parameter.value.IsObject()) {
+            m_staticParameters[name->GetString()] = std::move(parameter.value);
+            ++name;
+            continue;
+        }
+
+        apl::ObjectMap values;
+        for (const auto& member : parameter.value.GetObject()) {
+            values.emplace(member.name.GetString(), toObject(member.value));
+        }
+        parameter.liveMap = apl::LiveMap::create(std::move(values));
+        liveData.emplace(name->GetString(), parameter.liveMap);
+        m_liveParameters.emplace(name->GetString(), std::move(parameter));
+        name = names.Erase(name);
+    }
+    return liveData;
+}
+
+bool AplCoreGuiRenderer::renderDataOnly(const std::string& document, const std::string& data, const std::string& token) {
+    if (!m_liveContent || document != m_liveDocument || getTokenScope(token) != m_liveTokenScope ||
+        !m_aplCoreConnectionManager->isDisplaying(m_liveContent)) {
+        return false;
+    }
+
+    rapidjson::Document sources;
+    sources.Parse(data.c_str(), data.size());
+    if (sources.HasParseError()) {
+        return false;
+    }
+
+    // The parameters which are not live need a new render as soon as their value changes
+    for (const auto& parameter : m_staticParameters) {
+        rapidjson::Document value;
+        getParameterValue(parameter.first, sources, value);
+        if (value != parameter.second) {
+            return false;
+        }
+    }
+
+    // Check every parameter before changing any, so that a rejected update leaves the document untouched
+    std::unordered_map<std::string, rapidjson::Document> values;
+    for (const auto& parameter : m_liveParameters) {
+        rapidjson::Document value;
+        getParameterValue(parameter.first, sources, value);
+        if (!value.IsObject() || !canUpdateLive(parameter.second.value, value)) {
+            return false;
+        }
+        values.emplace(parameter.first, std::move(value));
+    }
+
+    for (auto& parameter : m_liveParameters) {
+        auto& current = parameter.second.value;
+        auto& next = values.at(parameter.first);
+        for (const auto& member : current.GetObject()) {
+            if (!next.HasMember(member.name)) {
+                parameter.second.liveMap->remove(member.name.GetString());
+            }
+        }
+        for (const auto& member : next.GetObject()) {
+            auto currentMember = current.FindMember(member.name);
+            if (currentMember == current.MemberEnd() || currentMember->value != member.value) {
+                parameter.second.liveMap->set(member.name.GetString(), toObject(member.value));
+            }
+        }
+        current = std::move(next);
+    }
+
+    m_liveTokenScope = getTokenScope(token);
+    m_isDocumentCleared = false;
+    m_aplCoreConnectionManager->onLiveDataUpdated(token);
+    return true;
+}
+
+void AplCoreGuiRenderer::clearLiveDocument() {
+    m_liveContent.reset();
+    m_liveDocument.clear();
+    m_liveTokenScope.clear();
+    m_liveParameters.clear();
+    m_staticParameters.clear();
+}
+
+void AplCoreGuiRenderer::setDataOnlyRenderEnabled(bool enabled) {
+    m_dataOnlyRenderEnabled = enabled;
+    if (!enabled) {
+        clearLiveDocument();
+    }
+}
+
+void AplCoreGuiRenderer::bindData(const apl::ContentPtr& content, apl::JsonData&& data) {
+    // Bind members of the parsed datasources directly, the default binding takes the whole payload once done
+    const auto& sources = data.get();
+    bool bindsPayload = false;
+    for (size_t idx = 0; idx < content->getParameterCount(); idx++) {
+        auto parameterName = content->getParameterAt(idx);
+        rapidjson::Value::ConstMemberIterator source;
+        if (parameterName == DEFAULT_PARAM_BINDING) {
+            bindsPayload = true;
+        } else if (sources.IsObject() && (source = sources.FindMember(parameterName.c_str())) != sources.MemberEnd()) {
+            rapidjson::Document value;
+            value.CopyFrom(source->value, value.GetAllocator());
+            content->addData(parameterName, apl::JsonData(std::move(value)));
+        } else {
+            content->addData(parameterName, DEFAULT_PARAM_VALUE);
+        }
+    }
+    if (bindsPayload) {
+        content->addData(DEFAULT_PARAM_BINDING, std::move(data));
     }
 }
 
 void AplCoreGuiRenderer::clearDocument() {
     m_isDocumentCleared = true;
+    clearLiveDocument();
     m_aplCoreConnectionManager->reset();
 }
 
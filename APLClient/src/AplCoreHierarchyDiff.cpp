@@ -0,0 +1,312 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+#include <rapidjson/writer.h>
+
+#include "APLClient/AplCoreHash.h"
+#include "APLClient/AplCoreHierarchyDiff.h"
+
+namespace APLClient {
+
+/// The keys of a serialized component which are not properties
+static const char UID_KEY[] = "id";
+static const char TYPE_KEY[] = "type";
+static const char CHILDREN_KEY[] = "children";
+
+/// The keys of the diff
+static const char REMOVED_KEY[] = "removed";
+static const char UPDATED_KEY[] = "updated";
+static const char ADDED_KEY[] = "added";
+static const char PARENT_KEY[] = "parent";
+static const char COMPONENT_KEY[] = "component";
+static const char PREVIOUS_UID_KEY[] = "uid";
+static const char NEW_UID_KEY[] = "newUid";
+static const char PROPERTIES_KEY[] = "properties";
+
+using AplCoreHash::hashBytes;
+using AplCoreHash::hashScalar;
+
+/**
+ * A rapidjson output stream hashing what is written to it instead of storing it
+ */
+class HashOutputStream {
+public:
+    typedef char Ch;
+
+    void Put(Ch c) {
+        hashBytes(m_hash, &c, 1);
+    }
+
+    void Flush() {}
+
+    uint64_t hash() const {
+        return m_hash;
+    }
+
+private:
+    uint64_t m_hash = AplCoreHash::OFFSET_BASIS;
+};
+
+static uint64_t hashValue(const rapidjson::Value& value) {
+    HashOutputStream stream;
+    rapidjson::Writer<HashOutputStream, rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator, rapidjson::kWriteNanAndInfFlag>
+        writer(stream);
+    value.Accept(writer);
+    return stream.hash();
+}
+
+static uint64_t contentKey(uint64_t type, uint64_t hash) {
+    hashScalar(hash, type);
+    return hash;
+}
+
+struct AplCoreHierarchyDiff::Diff {
+    explicit Diff(rapidjson::Document::AllocatorType& allocator) :
+            allocator(allocator),
+            removed(rapidjson::kArrayType),
+            updated(rapidjson::kArrayType),
+            added(rapidjson::kArrayType),
+            children(rapidjson::kObjectType) {
+    }
+
+    rapidjson::Document::AllocatorType& allocator;
+    rapidjson::Value removed;
+    rapidjson::Value updated;
+    rapidjson::Value added;
+    rapidjson::Value children;
+};
+
+void AplCoreHierarchyDiff::record(const rapidjson::Value& hierarchy) {
+    m_root = Fingerprint();
+    m_invalidated.clear();
+    if (hierarchy.IsObject()) {
+        fingerprintTree(hierarchy, m_root);
+    }
+}
+
+bool AplCoreHierarchyDiff::diff(
+        rapidjson::Value& hierarchy,
+        rapidjson::Document::AllocatorType& allocator,
+        rapidjson::Value& diff) {
+    if (empty() || !hierarchy.IsObject()) {
+        return false;
+    }
+
+    Fingerprint root;
+    fingerprint(hierarchy, root);
+    if (root.type != m_root.type) {
+        return false;
+    }
+
+    Diff result(allocator);
+    diffComponent(m_root, hierarchy, root, result);
+
+    diff.SetObject();
+    diff.AddMember(REMOVED_KEY, result.removed, allocator);
+    diff.AddMember(UPDATED_KEY, result.updated, allocator);
+    diff.AddMember(ADDED_KEY, result.added, allocator);
+    diff.AddMember(CHILDREN_KEY, result.children, allocator);
+
+    m_root = std::move(root);
+    m_invalidated.clear();
+    return true;
+}
+
+void AplCoreHierarchyDiff::invalidate(const std::string& uid) {
+    m_invalidated.insert(uid);
+}
+
+void AplCoreHierarchyDiff::clear() {
+    m_root = Fingerprint();
+    m_invalidated.clear();
+}
+
+void AplCoreHierarchyDiff::fingerprint(const rapidjson::Value& component, Fingerprint& fingerprint) {
+    fingerprint.uid.clear();
+    fingerprint.type = 0;
+    fingerprint.hash = AplCoreHash::OFFSET_BASIS;
+    fingerprint.properties.clear();
+    fingerprint.children.clear();
+
+    for (auto& member : component.GetObject()) {
+        const char* name = member.name.GetString();
+        if (std::strcmp(name, UID_KEY) == 0) {
+            if (member.value.IsString()) {
+                fingerprint.uid = member.value.GetString();
+            }
+        } else if (std::strcmp(name, TYPE_KEY) == 0) {
+            fingerprint.type = hashValue(member.value);
+        } else if (std::strcmp(name, CHILDREN_KEY) != 0) {
+            auto hash = hashValue(member.value);
+            fingerprint.properties.emplace_back(name, hash);
+            hashBytes(fingerprint.hash, name, member.name.GetStringLength() + 1);
+            hashScalar(fingerprint.hash, hash);
+        }
+    }
+}
+
+void AplCoreHierarchyDiff::fingerprintTree(const rapidjson::Value& component, Fingerprint& fingerprint) {
+    AplCoreHierarchyDiff::fingerprint(component, fingerprint);
+
+    auto children = component.FindMember(CHILDREN_KEY);
+    if (children == component.MemberEnd() || !children->value.IsArray()) {
+        return;
+    }
+    fingerprint.children.resize(children->value.Size());
+    for (rapidjson::SizeType i = 0; i < children->value.Size(); i++) {
+        if (children->value[i].IsObject()) {
+            fingerprintTree(children->value[i], fingerprint.children[i]);
+        }
+    }
+}
+
+void AplCoreHierarchyDiff::diffComponent(
+        const Fingerprint& previous,
+        rapidjson::Value& component,
+        Fingerprint& fingerprint,
+        Diff& diff) {
+    // The fingerprint already holds the properties of the component, which were needed to match it
+    auto& allocator = diff.allocator;
+    rapidjson::Value properties(rapidjson::kObjectType);
+    bool invalidated = m_invalidated.count(previous.uid) > 0;
+    if (invalidated || fingerprint.hash != previous.hash) {
+        for (auto& property : fingerprint.properties) {
+            auto it = std::find_if(
+                previous.properties.begin(),
+                previous.properties.end(),
+                [&property](const std::pair<std::string, uint64_t>& candidate) {
+                    return candidate.first == property.first;
+                });
+            if (invalidated || it == previous.properties.end() || it->second != property.second) {
+                properties.AddMember(
+                    rapidjson::Value(property.first.c_str(), allocator),
+                    rapidjson::Value(component[property.first.c_str()], allocator),
+                    allocator);
+            }
+        }
+        for (auto& property : previous.properties) {
+            auto it = std::find_if(
+                fingerprint.properties.begin(),
+                fingerprint.properties.end(),
+                [&property](const std::pair<std::string, uint64_t>& candidate) {
+                    return candidate.first == property.first;
+                });
+            if (it == fingerprint.properties.end()) {
+                properties.AddMember(rapidjson::Value(property.first.c_str(), allocator), rapidjson::Value(), allocator);
+            }
+        }
+    }
+
+    bool uidChanged = fingerprint.uid != previous.uid;
+    if (uidChanged || properties.MemberCount() > 0) {
+        rapidjson::Value update(rapidjson::kObjectType);
+        update.AddMember(PREVIOUS_UID_KEY, rapidjson::Value(previous.uid.c_str(), allocator), allocator);
+        if (uidChanged) {
+            update.AddMember(NEW_UID_KEY, rapidjson::Value(fingerprint.uid.c_str(), allocator), allocator);
+        }
+        if (properties.MemberCount() > 0) {
+            update.AddMember(PROPERTIES_KEY, properties, allocator);
+        }
+        diff.updated.PushBack(update, allocator);
+    }
+
+    auto childrenMember = component.FindMember(CHILDREN_KEY);
+    rapidjson::SizeType count = 0;
+    if (childrenMember != component.MemberEnd() && childrenMember->value.IsArray()) {
+        count = childrenMember->value.Size();
+    }
+    fingerprint.children.resize(count);
+
+    // Match unchanged children first, wherever they moved, then the remaining ones in order by type
+    std::vector<int> matched(count, -1);
+    std::vector<bool> used(previous.children.size(), false);
+    std::unordered_map<uint64_t, std::deque<size_t>> unchanged;
+    for (size_t j = 0; j < previous.children.size(); j++) {
+        auto& child = previous.children[j];
+        unchanged[contentKey(child.type, child.hash)].push_back(j);
+    }
+    for (rapidjson::SizeType i = 0; i < count; i++) {
+        auto& child = childrenMember->value[i];
+        if (!child.IsObject()) {
+            continue;
+        }
+        auto& childFingerprint = fingerprint.children[i];
+        AplCoreHierarchyDiff::fingerprint(child, childFingerprint);
+        auto it = unchanged.find(contentKey(childFingerprint.type, childFingerprint.hash));
+        if (it != unchanged.end() && !it->second.empty()) {
+            matched[i] = static_cast<int>(it->second.front());
+            used[it->second.front()] = true;
+            it->second.pop_front();
+        }
+    }
+
+    std::unordered_map<uint64_t, std::deque<size_t>> byType;
+    for (size_t j = 0; j < previous.children.size(); j++) {
+        if (!used[j]) {
+            byType[previous.children[j].type].push_back(j);
+        }
+    }
+    for (rapidjson::SizeType i = 0; i < count; i++) {
+        if (matched[i] >= 0 || !childrenMember->value[i].IsObject()) {
+            continue;
+        }
+        auto it = byType.find(fingerprint.children[i].type);
+        if (it != byType.end() && !it->second.empty()) {
+            matched[i] = static_cast<int>(it->second.front());
+            used[it->second.front()] = true;
+            it->second.pop_front();
+        }
+    }
+
+    bool childrenChanged = count != previous.children.size();
+    for (rapidjson::SizeType i = 0; i < count; i++) {
+        auto& child = childrenMember->value[i];
+        if (!child.IsObject()) {
+            continue;
+        }
+        if (matched[i] >= 0) {
+            childrenChanged |= matched[i] != static_cast<int>(i);
+            diffComponent(previous.children[matched[i]], child, fingerprint.children[i], diff);
+        } else {
+            childrenChanged = true;
+            fingerprintTree(child, fingerprint.children[i]);
+            rapidjson::Value addition(rapidjson::kObjectType);
+            addition.AddMember(PARENT_KEY, rapidjson::Value(fingerprint.uid.c_str(), allocator), allocator);
+            addition.AddMember(COMPONENT_KEY, child, allocator);
+            diff.added.PushBack(addition, allocator);
+        }
+    }
+
+    for (size_t j = 0; j < previous.children.size(); j++) {
+        if (!used[j]) {
+            diff.removed.PushBack(rapidjson::Value(previous.children[j].uid.c_str(), allocator), allocator);
+        }
+    }
+
+    if (childrenChanged) {
+        rapidjson::Value order(rapidjson::kArrayType);
+        for (auto& child : fingerprint.children) {
+            order.PushBack(rapidjson::Value(child.uid.c_str(), allocator), allocator);
+        }
+        diff.children.AddMember(rapidjson::Value(fingerprint.uid.c_str(), allocator), order, allocator);
+    }
+}
+
+}  // namespace APLClient
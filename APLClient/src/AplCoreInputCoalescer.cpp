@@ -0,0 +1,51 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <iterator>
+
+#include "APLClient/AplCoreInputCoalescer.h"
+
+namespace APLClient {
+
+void AplCoreInputCoalescer::push(const std::string& type, const std::string& key, const rapidjson::Value& payload) {
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_entries.erase(it->second);
+    }
+
+    m_entries.emplace_back();
+    auto& entry = m_entries.back();
+    entry.type = type;
+    entry.key = key;
+    entry.payload.CopyFrom(payload, entry.payload.GetAllocator());
+    m_index[key] = std::prev(m_entries.end());
+}
+
+void AplCoreInputCoalescer::flush(const Handler& handler) {
+    // A handler may queue further messages, which wait for the next flush
+    std::list<Entry> entries;
+    entries.swap(m_entries);
+    m_index.clear();
+    for (const auto& entry : entries) {
+        handler(entry.type, entry.payload);
+    }
+}
+
+void AplCoreInputCoalescer::clear() {
+    m_entries.clear();
+    m_index.clear();
+}
+
+}  // namespace APLClient
@@ -0,0 +1,242 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <cstdint>
+
+#include "APLClient/AplCoreLocaleCasing.h"
+
+namespace APLClient {
+
+    /// Languages whose casing of i differs from the default rules
+    static const char TURKISH_LANGUAGE[] = "tr";
+    static const char AZERBAIJANI_LANGUAGE[] = "az";
+    /// Language which keeps the dot of i when accented
+    static const char LITHUANIAN_LANGUAGE[] = "lt";
+
+    static const uint32_t GREEK_CAPITAL_SIGMA = 0x3A3;
+    static const uint32_t GREEK_FINAL_SIGMA = 0x3C2;
+
+    /**
+     * @return The lower cased primary language subtag of a BCP-47 locale
+     */
+    static std::string language(const std::string &locale) {
+        std::string language;
+        for (auto c : locale) {
+            if (c == '-' || c == '_') {
+                break;
+            }
+            language += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+        return language;
+    }
+
+    /**
+     * Decodes one code point from a UTF-8 string
+     *
+     * @return false if the string is not valid UTF-8 at @c pos
+     */
+    static bool decode(const std::string &value, size_t &pos, uint32_t &codePoint) {
+        auto lead = static_cast<unsigned char>(value[pos]);
+        size_t length;
+        if (lead < 0x80) {
+            codePoint = lead;
+            length = 1;
+        } else if ((lead & 0xE0) == 0xC0) {
+            codePoint = lead & 0x1F;
+            length = 2;
+        } else if ((lead & 0xF0) == 0xE0) {
+            codePoint = lead & 0x0F;
+            length = 3;
+        } else if ((lead & 0xF8) == 0xF0) {
+            codePoint = lead & 0x07;
+            length = 4;
+        } else {
+            return false;
+        }
+
+        if (pos + length > value.size()) {
+            return false;
+        }
+        for (size_t i = 1; i < length; i++) {
+            auto next = static_cast<unsigned char>(value[pos + i]);
+            if ((next & 0xC0) != 0x80) {
+                return false;
+            }
+            codePoint = (codePoint << 6) | (next & 0x3F);
+        }
+        pos += length;
+        return true;
+    }
+
+    static void encode(uint32_t codePoint, std::string &out) {
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    /**
+     * Cases a code point of a block where upper and lower case letters alternate
+     *
+     * @param upperIsEven Whether the upper case letter of each pair has the even code point
+     */
+    static uint32_t casePair(uint32_t codePoint, bool upper, bool upperIsEven) {
+        bool isUpper = ((codePoint % 2) == 0) == upperIsEven;
+        if (upper && !isUpper) {
+            return upperIsEven ? codePoint - 1 : codePoint + 1;
+        }
+        if (!upper && isUpper) {
+            return upperIsEven ? codePoint + 1 : codePoint - 1;
+        }
+        return codePoint;
+    }
+
+    /**
+     * @return true for code points in blocks without case
+     */
+    static bool isCaseless(uint32_t codePoint) {
+        return (codePoint >= 0x2000 && codePoint <= 0x206F)      // General Punctuation
+            || (codePoint >= 0x3000 && codePoint <= 0x30FF)      // CJK Symbols, Hiragana, Katakana
+            || (codePoint >= 0x4E00 && codePoint <= 0x9FFF)      // CJK Unified Ideographs
+            || (codePoint >= 0xAC00 && codePoint <= 0xD7A3)      // Hangul Syllables
+            || (codePoint >= 0x1F000 && codePoint <= 0x1FAFF);   // Emoji and pictographs
+    }
+
+    /**
+     * Appends the cased form of a code point
+     *
+     * @return false if the code point cannot be cased without locale data
+     */
+    static bool caseCodePoint(uint32_t codePoint, bool upper, std::string &out) {
+        uint32_t cased = codePoint;
+        if (codePoint < 0x80) {
+            if (upper && codePoint >= 'a' && codePoint <= 'z') {
+                cased = codePoint - 'a' + 'A';
+            } else if (!upper && codePoint >= 'A' && codePoint <= 'Z') {
+                cased = codePoint - 'A' + 'a';
+            }
+        } else if (codePoint < 0xC0) {
+            // Latin-1 punctuation, only the micro sign has an upper case form
+            if (upper && codePoint == 0xB5) {
+                cased = 0x39C;
+            }
+        } else if (codePoint == 0xD7 || codePoint == 0xF7) {
+            // Multiplication and division signs
+        } else if (codePoint <= 0xDE) {
+            cased = upper ? codePoint : codePoint + 0x20;
+        } else if (codePoint == 0xDF) {
+            // Sharp s upper cases to two letters
+            if (upper) {
+                out += "SS";
+                return true;
+            }
+        } else if (codePoint <= 0xFE) {
+            cased = upper ? codePoint - 0x20 : codePoint;
+        } else if (codePoint == 0xFF) {
+            cased = upper ? 0x178 : codePoint;
+        } else if (codePoint <= 0x12F || (codePoint >= 0x132 && codePoint <= 0x137) ||
+                   (codePoint >= 0x14A && codePoint <= 0x177)) {
+            cased = casePair(codePoint, upper, true);
+        } else if (codePoint == 0x130 || codePoint == 0x131 || codePoint == 0x149) {
+            // Dotted and dotless i depend on the locale, n preceded by apostrophe expands
+            return false;
+        } else if (codePoint == 0x138) {
+            // Kra has no upper case form
+        } else if ((codePoint >= 0x139 && codePoint <= 0x148) || (codePoint >= 0x179 && codePoint <= 0x17E)) {
+            cased = casePair(codePoint, upper, false);
+        } else if (codePoint == 0x178) {
+            cased = upper ? codePoint : 0xFF;
+        } else if (codePoint == 0x17F) {
+            cased = upper ? 'S' : codePoint;
+        } else if (codePoint >= 0x391 && codePoint <= 0x3A9 && codePoint != 0x3A2) {
+            if (!upper && codePoint == GREEK_CAPITAL_SIGMA) {
+                // Lower case sigma depends on its position in the word
+                return false;
+            }
+            cased = upper ? codePoint : codePoint + 0x20;
+        } else if (codePoint >= 0x3B1 && codePoint <= 0x3C9) {
+            if (codePoint == GREEK_FINAL_SIGMA) {
+                cased = upper ? GREEK_CAPITAL_SIGMA : codePoint;
+            } else {
+                cased = upper ? codePoint - 0x20 : codePoint;
+            }
+        } else if (codePoint >= 0x400 && codePoint <= 0x40F) {
+            cased = upper ? codePoint : codePoint + 0x50;
+        } else if (codePoint >= 0x410 && codePoint <= 0x42F) {
+            cased = upper ? codePoint : codePoint + 0x20;
+        } else if (codePoint >= 0x430 && codePoint <= 0x44F) {
+            cased = upper ? codePoint - 0x20 : codePoint;
+        } else if (codePoint >= 0x450 && codePoint <= 0x45F) {
+            cased = upper ? codePoint - 0x50 : codePoint;
+        } else if (!isCaseless(codePoint)) {
+            return false;
+        }
+
+        encode(cased, out);
+        return true;
+    }
+
+    bool AplCoreLocaleCasing::toUpperCase(const std::string &value, const std::string &locale, std::string &result) {
+        return toCase(value, locale, true, result);
+    }
+
+    bool AplCoreLocaleCasing::toLowerCase(const std::string &value, const std::string &locale, std::string &result) {
+        return toCase(value, locale, false, result);
+    }
+
+    bool AplCoreLocaleCasing::toCase(
+            const std::string &value,
+            const std::string &locale,
+            bool upper,
+            std::string &result) {
+        auto lang = language(locale);
+        bool dottedI = lang == TURKISH_LANGUAGE || lang == AZERBAIJANI_LANGUAGE;
+        bool lithuanian = lang == LITHUANIAN_LANGUAGE;
+
+        std::string out;
+        out.reserve(value.size());
+        size_t pos = 0;
+        while (pos < value.size()) {
+            uint32_t codePoint;
+            if (!decode(value, pos, codePoint)) {
+                return false;
+            }
+            if (dottedI && (codePoint == 'i' || codePoint == 'I')) {
+                return false;
+            }
+            if (lithuanian && codePoint >= 0x80) {
+                return false;
+            }
+            if (!caseCodePoint(codePoint, upper, out)) {
+                return false;
+            }
+        }
+
+        result = std::move(out);
+        return true;
+    }
+
+}  // namespace APLClient
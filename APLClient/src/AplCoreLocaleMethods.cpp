@@ -16,6 +16,7 @@
 #include <climits>
 
 #include "APLClient/AplCoreViewhostMessage.h"
+#include "APLClient/AplCoreLocaleCasing.h"
 #include "APLClient/AplCoreLocaleMethods.h"
 
 namespace APLClient {
@@ -23,6 +24,9 @@ namespace APLClient {
     static const char UPPER_KEY[] = "toUpperCase";
     static const char LOWER_KEY[] = "toLowerCase";
 
+    /// The maximum number of viewhost replies remembered before the memo is reset
+    static const size_t MAX_VIEWHOST_RESULTS = 256;
+
     AplCoreLocaleMethods::AplCoreLocaleMethods(
             AplCoreConnectionManagerPtr aplCoreConnectionManager,
             AplConfigurationPtr config)
@@ -31,14 +35,28 @@ namespace APLClient {
     }
 
     std::string AplCoreLocaleMethods::toUpperCase(const std::string &value, const std::string &locale) {
+        std::string result;
+        if (AplCoreLocaleCasing::toUpperCase(value, locale, result)) {
+            return result;
+        }
         return toCase(value, locale, UPPER_KEY);
     }
     std::string AplCoreLocaleMethods::toLowerCase(const std::string &value, const std::string &locale) {
+        std::string result;
+        if (AplCoreLocaleCasing::toLowerCase(value, locale, result)) {
+            return result;
+        }
         return toCase(value, locale, LOWER_KEY);
     }
 
     std::string AplCoreLocaleMethods::toCase(const std::string &value, const std::string &locale, const std::string methodName) {
         auto aplOptions = m_aplConfiguration->getAplOptions();
+        auto memoKey = methodName + '\0' + locale + '\0' + value;
+        auto memoItr = m_viewhostResults.find(memoKey);
+        if (memoItr != m_viewhostResults.end()) {
+            return memoItr->second;
+        }
+
         if (auto aplCoreConnectionManager = m_aplCoreConnectionManager.lock()) {
             auto msg = AplCoreViewhostMessage(LOCALE_METHODS_KEY);
             auto& alloc = msg.alloc();
@@ -52,8 +70,18 @@ namespace APLClient {
             auto result = aplCoreConnectionManager->blockingSend(msg);
 
             if (result.IsObject()) {
-                auto casedValue = result["payload"]["value"].GetString();
-                return casedValue;
+                auto payloadItr = result.FindMember("payload");
+                if (payloadItr != result.MemberEnd() && payloadItr->value.IsObject()) {
+                    auto valueItr = payloadItr->value.FindMember("value");
+                    if (valueItr != payloadItr->value.MemberEnd() && valueItr->value.IsString()) {
+                        std::string casedValue = valueItr->value.GetString();
+                        if (m_viewhostResults.size() >= MAX_VIEWHOST_RESULTS) {
+                            m_viewhostResults.clear();
+                        }
+                        m_viewhostResults.emplace(std::move(memoKey), casedValue);
+                        return casedValue;
+                    }
+                }
             }
 
             aplOptions->logMessage(LogLevel::WARN, __func__, "Didn't get a valid reply.  Returning unlocalized value.");
@@ -53,7 +53,13 @@ AplCoreMediaPlayer::AplCoreMediaPlayer(AplCoreConnectionManagerWPtr aplCoreConne
         payload.AddMember("playerId", rapidjson::Value(m_playerId.c_str(), alloc).Move(), alloc);
         msg.setPayload(std::move(payload));
 
-        connectionManager->blockingSend(msg);
+        // Commands for this player are sent in order behind the create request, so don't stall the core on the reply
+        auto config = m_aplConfiguration;
+        connectionManager->sendRequest(msg, [config](const AplCoreViewhostInboundMessage& reply) {
+            if (!reply.isValid()) {
+                config->getAplOptions()->logMessage(LogLevel::WARN, "mediaPlayerCreate", "Did not receive response");
+            }
+        });
     } else {
         auto aplOptions = m_aplConfiguration->getAplOptions();
         aplOptions->logMessage(LogLevel::WARN, __func__, "ConnectionManager does not exist. Can't send mediaPlayerCreate");
@@ -73,7 +79,7 @@ void
 AplCoreMediaPlayer::sendMediaPlayerCommand(const std::string& command, rapidjson::Value&& payload)
 {
     if (auto connectionManager = m_aplCoreConnectionManager.lock()) {
-        auto msg = AplCoreViewhostMessage(command);
+        auto msg = AplCoreViewhostMessage(command, connectionManager->messageArena());
         auto& alloc = msg.alloc();
 
         payload.AddMember("playerId", rapidjson::Value(m_playerId.c_str(), alloc).Move(), alloc);
@@ -0,0 +1,179 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "APLClient/AplCoreHash.h"
+#include "APLClient/AplCorePackageCache.h"
+
+namespace APLClient {
+
+/// The extension of the package files of the disk tier
+static const char PACKAGE_FILE_EXTENSION[] = ".json";
+
+const size_t AplCorePackageCache::DEFAULT_MAX_ENTRIES;
+
+AplCorePackageCache::AplCorePackageCache(size_t maxEntries) : m_maxEntries{maxEntries}, m_tempFileCount{0} {
+}
+
+AplCorePackageCache::Key AplCorePackageCache::makeKey(
+        const std::string& name,
+        const std::string& version,
+        const std::string& source) {
+    Key key;
+    key.reserve(name.size() + version.size() + source.size() + 2);
+    key.append(name).append(1, '\0').append(version).append(1, '\0').append(source);
+    return key;
+}
+
+void AplCorePackageCache::setDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_directory = directory;
+    if (!m_directory.empty() && m_directory.back() != '/' && m_directory.back() != '\\') {
+        m_directory += '/';
+    }
+}
+
+bool AplCorePackageCache::get(const Key& key, rapidjson::Document& package) {
+    // Only the lookups hold the mutex, copying, reading and parsing packages leaves other imports to proceed
+    Package stored;
+    std::string filePath;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            stored = it->second->second;
+        } else if (!m_directory.empty()) {
+            filePath = path(key);
+        }
+    }
+
+    if (stored) {
+        package.CopyFrom(*stored, package.GetAllocator());
+        return true;
+    }
+    if (filePath.empty()) {
+        return false;
+    }
+
+    std::string raw;
+    if (!readFile(filePath, key, raw)) {
+        return false;
+    }
+    auto parsed = std::make_shared<rapidjson::Document>();
+    parsed->Parse(raw.c_str(), raw.size());
+    if (parsed->HasParseError()) {
+        return false;
+    }
+
+    package.CopyFrom(*parsed, package.GetAllocator());
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_index.find(key) == m_index.end()) {
+        insert(key, std::move(parsed));
+    }
+    return true;
+}
+
+void AplCorePackageCache::put(const Key& key, const std::string& raw, const rapidjson::Value& package) {
+    auto stored = std::make_shared<rapidjson::Document>();
+    stored->CopyFrom(package, stored->GetAllocator());
+
+    std::string filePath;
+    std::string tempPath;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (m_index.find(key) == m_index.end()) {
+            insert(key, std::move(stored));
+        }
+        if (m_directory.empty()) {
+            return;
+        }
+        filePath = path(key);
+        // Concurrent writers of the same package each write their own temporary file
+        tempPath = filePath + "." + std::to_string(m_tempFileCount++) + ".tmp";
+    }
+
+    // Write to a temporary file first so that a reader never sees a partially written package. The file starts with
+    // the key, as its name is only a hash of it.
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file << key.size() << '\n';
+        file.write(key.data(), key.size());
+        file.write(raw.data(), raw.size());
+        if (!file) {
+            file.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    std::remove(filePath.c_str());
+    if (std::rename(tempPath.c_str(), filePath.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+    }
+}
+
+void AplCorePackageCache::clear() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_entries.clear();
+    m_index.clear();
+}
+
+size_t AplCorePackageCache::size() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_entries.size();
+}
+
+void AplCorePackageCache::insert(const Key& key, Package package) {
+    m_entries.emplace_front(key, std::move(package));
+    m_index[key] = m_entries.begin();
+    while (m_entries.size() > m_maxEntries) {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+bool AplCorePackageCache::readFile(const std::string& filePath, const Key& key, std::string& raw) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    // A file of another package whose key hashes to the same name, or of an older format, is a miss
+    size_t keySize = 0;
+    if (!(file >> keySize) || file.get() != '\n' || keySize != key.size()) {
+        return false;
+    }
+    std::string storedKey(keySize, '\0');
+    if (!file.read(&storedKey[0], keySize) || storedKey != key) {
+        return false;
+    }
+
+    raw.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string AplCorePackageCache::path(const Key& key) const {
+    auto hash = AplCoreHash::hash(key.data(), key.size());
+
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return m_directory + name + PACKAGE_FILE_EXTENSION;
+}
+
+}  // namespace APLClient
@@ -0,0 +1,111 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "APLClient/AplCorePackageDownloader.h"
+
+namespace APLClient {
+
+AplCorePackageDownloader::AplCorePackageDownloader(AplOptionsInterfacePtr aplOptions, int maxConcurrentDownloads)
+        : m_aplOptions{aplOptions},
+          m_maxWorkers{maxConcurrentDownloads > 0 ? static_cast<size_t>(maxConcurrentDownloads) : 1},
+          m_idleWorkers{0},
+          m_stopping{false} {
+}
+
+AplCorePackageDownloader::~AplCorePackageDownloader() {
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stopping = true;
+    }
+    m_requestCondition.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+std::unique_ptr<AplCorePackageDownloader::Batch> AplCorePackageDownloader::createBatch() {
+    return std::unique_ptr<Batch>(new Batch(*this, std::make_shared<BatchState>()));
+}
+
+AplCorePackageDownloader::Batch::Batch(AplCorePackageDownloader& downloader, std::shared_ptr<BatchState> state)
+        : m_downloader(downloader),
+          m_state{std::move(state)} {
+}
+
+AplCorePackageDownloader::Batch::~Batch() {
+    std::lock_guard<std::mutex> lock{m_downloader.m_mutex};
+    m_state->abandoned = true;
+    m_state->completed.clear();
+    auto& requests = m_downloader.m_requests;
+    auto state = m_state.get();
+    requests.erase(
+        std::remove_if(
+            requests.begin(), requests.end(), [state](const Request& request) { return request.batch.get() == state; }),
+        requests.end());
+}
+
+void AplCorePackageDownloader::Batch::request(uint32_t requestId, const std::string& source) {
+    std::lock_guard<std::mutex> lock{m_downloader.m_mutex};
+    m_downloader.m_requests.push_back(Request{m_state, requestId, source});
+    m_state->outstanding++;
+    if (m_downloader.m_idleWorkers < m_downloader.m_requests.size() &&
+        m_downloader.m_workers.size() < m_downloader.m_maxWorkers) {
+        m_downloader.m_workers.emplace_back(&AplCorePackageDownloader::run, &m_downloader);
+    }
+    m_downloader.m_requestCondition.notify_one();
+}
+
+bool AplCorePackageDownloader::Batch::next(uint32_t& requestId, std::string& content) {
+    std::unique_lock<std::mutex> lock{m_downloader.m_mutex};
+    if (m_state->outstanding == 0) {
+        return false;
+    }
+    auto state = m_state.get();
+    state->completion.wait(lock, [state]() { return !state->completed.empty(); });
+
+    requestId = state->completed.front().first;
+    content = std::move(state->completed.front().second);
+    state->completed.pop_front();
+    state->outstanding--;
+    return true;
+}
+
+void AplCorePackageDownloader::run() {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    while (true) {
+        m_idleWorkers++;
+        m_requestCondition.wait(lock, [this]() { return m_stopping || !m_requests.empty(); });
+        m_idleWorkers--;
+        if (m_stopping) {
+            return;
+        }
+
+        auto request = std::move(m_requests.front());
+        m_requests.pop_front();
+        lock.unlock();
+        auto content = m_aplOptions->downloadResource(request.source);
+        lock.lock();
+
+        // A batch abandoned while its download was in flight no longer wants it
+        if (!request.batch->abandoned) {
+            request.batch->completed.emplace_back(request.requestId, std::move(content));
+            request.batch->completion.notify_one();
+        }
+    }
+}
+
+}  // namespace APLClient
@@ -0,0 +1,105 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <climits>
+
+#include "APLClient/AplCoreTextMeasureBatch.h"
+
+namespace APLClient {
+
+/// The keys used in APL batched text measurement.
+static const char MEASURE_BATCH_KEY[] = "measureBatch";
+
+/// The time to wait for the reply to a batch, which covers many measurements
+static const std::chrono::milliseconds MEASURE_BATCH_TIMEOUT{5000};
+
+AplCoreTextMeasureBatch::AplCoreTextMeasureBatch(AplCoreMetricsPtr aplCoreMetrics, AplConfigurationPtr config)
+    : m_aplCoreMetrics{aplCoreMetrics},
+      m_aplConfiguration{config},
+      m_textMeasureCache{config->getTextMeasureCache()},
+      m_message{MEASURE_BATCH_KEY},
+      m_requests{rapidjson::kArrayType} {
+}
+
+apl::LayoutSize AplCoreTextMeasureBatch::measure(
+        apl::Component* component,
+        float width,
+        apl::MeasureMode widthMode,
+        float height,
+        apl::MeasureMode heightMode) {
+    auto& alloc = m_message.alloc();
+    auto viewhostWidth = m_aplCoreMetrics->toViewhost(std::isnan(width) ? (float)INT_MAX : width);
+    auto viewhostHeight = m_aplCoreMetrics->toViewhost(std::isnan(height) ? (float)INT_MAX : height);
+
+    rapidjson::Value payload(component->serialize(alloc));
+    auto key = AplCoreTextMeasureCache::makeKey(payload, viewhostWidth, widthMode, viewhostHeight, heightMode);
+    AplCoreTextMeasureCache::Entry entry;
+    if (m_textMeasureCache->get(key, entry)) {
+        return {m_aplCoreMetrics->toCore(entry.width), m_aplCoreMetrics->toCore(entry.height)};
+    }
+
+    if (m_recorded.insert(key).second) {
+        payload.AddMember("width", viewhostWidth, alloc);
+        payload.AddMember("height", viewhostHeight, alloc);
+        payload.AddMember("widthMode", widthMode, alloc);
+        payload.AddMember("heightMode", heightMode, alloc);
+        m_requests.PushBack(std::move(payload), alloc);
+        m_keys.push_back(key);
+    }
+
+    // Estimate from the constraints, only the constraints of later requests depend on it
+    float estimatedWidth = (widthMode == apl::MeasureMode::Undefined || std::isnan(width)) ? 0 : width;
+    float estimatedHeight = (heightMode == apl::MeasureMode::Exactly && !std::isnan(height)) ? height : 0;
+    return {estimatedWidth, estimatedHeight};
+}
+
+float AplCoreTextMeasureBatch::baseline(apl::Component* component, float width, float height) {
+    return height;
+}
+
+size_t AplCoreTextMeasureBatch::send(AplCoreConnectionManager& aplCoreConnectionManager) {
+    if (m_keys.empty()) {
+        return 0;
+    }
+
+    auto aplOptions = m_aplConfiguration->getAplOptions();
+    auto result = aplCoreConnectionManager.blockingSend(
+        m_message.setPayload(std::move(m_requests)), MEASURE_BATCH_TIMEOUT);
+    m_requests = rapidjson::Value(rapidjson::kArrayType);
+
+    if (!result.IsObject()) {
+        aplOptions->logMessage(LogLevel::WARN, __func__, "Didn't get a valid measureBatch reply.");
+        return 0;
+    }
+
+    auto payloadItr = result.FindMember("payload");
+    if (payloadItr == result.MemberEnd() || !payloadItr->value.IsArray()) {
+        aplOptions->logMessage(LogLevel::WARN, __func__, "measureBatch reply does not contain results.");
+        return 0;
+    }
+
+    auto& results = payloadItr->value;
+    size_t added = 0;
+    for (rapidjson::SizeType i = 0; i < results.Size() && i < m_keys.size(); i++) {
+        AplCoreTextMeasureCache::Entry entry;
+        if (AplCoreTextMeasureCache::parseEntry(results[i], entry)) {
+            m_textMeasureCache->put(m_keys[i], entry);
+            added++;
+        }
+    }
+    return added;
+}
+
+}  // namespace APLClient
@@ -0,0 +1,164 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <cstring>
+
+#include "APLClient/AplCoreHash.h"
+#include "APLClient/AplCoreTextMeasureCache.h"
+
+namespace APLClient {
+
+using AplCoreHash::hashBytes;
+using AplCoreHash::hashScalar;
+
+/// The component property holding the unique id, which is excluded from the key
+static const char ID_KEY[] = "id";
+
+/// The measurement keys in a viewhost reply
+static const char WIDTH_KEY[] = "width";
+static const char HEIGHT_KEY[] = "height";
+static const char BASELINE_KEY[] = "baseline";
+static const char LINE_COUNT_KEY[] = "lineCount";
+static const char LAST_LINE_WIDTH_KEY[] = "lastLineWidth";
+
+const size_t AplCoreTextMeasureCache::DEFAULT_MAX_ENTRIES;
+
+static void hashValue(uint64_t& hash, const rapidjson::Value& value) {
+    hashScalar(hash, static_cast<int>(value.GetType()));
+    switch (value.GetType()) {
+        case rapidjson::kNumberType:
+            hashScalar(hash, value.GetDouble());
+            break;
+        case rapidjson::kStringType:
+            hashBytes(hash, value.GetString(), value.GetStringLength());
+            break;
+        case rapidjson::kArrayType:
+            hashScalar(hash, value.Size());
+            for (auto& item : value.GetArray()) {
+                hashValue(hash, item);
+            }
+            break;
+        case rapidjson::kObjectType:
+            hashScalar(hash, value.MemberCount());
+            for (auto& member : value.GetObject()) {
+                hashBytes(hash, member.name.GetString(), member.name.GetStringLength());
+                hashValue(hash, member.value);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+AplCoreTextMeasureCache::AplCoreTextMeasureCache(size_t maxEntries) : m_maxEntries{maxEntries} {
+}
+
+AplCoreTextMeasureCache::Key AplCoreTextMeasureCache::makeKey(
+        const rapidjson::Value& properties,
+        float width,
+        int widthMode,
+        float height,
+        int heightMode) {
+    uint64_t hash = AplCoreHash::OFFSET_BASIS;
+    if (properties.IsObject()) {
+        for (auto& member : properties.GetObject()) {
+            auto name = member.name.GetString();
+            // Skip the unique id and layout output such as bounds, which do not affect the measured size
+            if (name[0] == '_' || std::strcmp(name, ID_KEY) == 0) {
+                continue;
+            }
+            hashBytes(hash, name, member.name.GetStringLength());
+            hashValue(hash, member.value);
+        }
+    }
+    hashScalar(hash, width);
+    hashScalar(hash, widthMode);
+    hashScalar(hash, height);
+    hashScalar(hash, heightMode);
+    return hash;
+}
+
+bool AplCoreTextMeasureCache::parseEntry(const rapidjson::Value& payload, Entry& entry) {
+    if (!payload.IsObject()) {
+        return false;
+    }
+
+    auto widthItr = payload.FindMember(WIDTH_KEY);
+    auto heightItr = payload.FindMember(HEIGHT_KEY);
+    if (widthItr == payload.MemberEnd() || heightItr == payload.MemberEnd() ||
+        !widthItr->value.IsNumber() || !heightItr->value.IsNumber()) {
+        return false;
+    }
+
+    entry = Entry(widthItr->value.GetFloat(), heightItr->value.GetFloat());
+
+    // Viewhosts may lay the text out once and return its metrics with the size
+    auto baselineItr = payload.FindMember(BASELINE_KEY);
+    if (baselineItr != payload.MemberEnd() && baselineItr->value.IsNumber()) {
+        entry.hasBaseline = true;
+        entry.baseline = baselineItr->value.GetFloat();
+
+        auto lineCountItr = payload.FindMember(LINE_COUNT_KEY);
+        if (lineCountItr != payload.MemberEnd() && lineCountItr->value.IsInt()) {
+            entry.lineCount = lineCountItr->value.GetInt();
+        }
+        auto lastLineWidthItr = payload.FindMember(LAST_LINE_WIDTH_KEY);
+        if (lastLineWidthItr != payload.MemberEnd() && lastLineWidthItr->value.IsNumber()) {
+            entry.lastLineWidth = lastLineWidthItr->value.GetFloat();
+        }
+    }
+    return true;
+}
+
+bool AplCoreTextMeasureCache::get(Key key, Entry& entry) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return false;
+    }
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    entry = it->second->second;
+    return true;
+}
+
+void AplCoreTextMeasureCache::put(Key key, const Entry& entry) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        it->second->second = entry;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+
+    m_entries.emplace_front(key, entry);
+    m_index[key] = m_entries.begin();
+    while (m_entries.size() > m_maxEntries) {
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+}
+
+void AplCoreTextMeasureCache::clear() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_entries.clear();
+    m_index.clear();
+}
+
+size_t AplCoreTextMeasureCache::size() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_entries.size();
+}
+
+}  // namespace APLClient
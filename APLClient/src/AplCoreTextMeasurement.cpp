@@ -14,6 +14,7 @@
  */
 
 #include <climits>
+#include <cmath>
 
 #include "APLClient/AplCoreViewhostMessage.h"
 #include "APLClient/AplCoreTextMeasurement.h"
@@ -24,15 +25,54 @@ namespace APLClient {
 static const char MEASURE_KEY[] = "measure";
 static const char BASELINE_KEY[] = "baseline";
 
+/// The difference in viewhost units below which a measured size is considered the size a baseline is requested for
+static const float BASELINE_SIZE_TOLERANCE = 0.5f;
+
+/// The maximum number of measured baselines remembered before they are forgotten. Core asks for the baseline of a
+/// text right after measuring it, so only the latest measurements need to be kept.
+static const size_t MAX_MEASURED_BASELINES = 256;
+
 AplCoreTextMeasurement::AplCoreTextMeasurement(
         AplCoreConnectionManagerPtr aplCoreConnectionManager,
         AplConfigurationPtr config)
     : m_aplCoreConnectionManager{aplCoreConnectionManager},
-      m_aplConfiguration{config} {
+      m_aplConfiguration{config},
+      m_textMeasureCache{config->getTextMeasureCache()} {
 
-    m_textMeasureCounter = m_aplConfiguration->getMetricsRecorder()->createCounter(
+    auto metricsRecorder = m_aplConfiguration->getMetricsRecorder();
+    m_textMeasureCounter = metricsRecorder->createCounter(
             Telemetry::AplMetricsRecorderInterface::LATEST_DOCUMENT,
    Telemetry::AplRenderingSegment::kTextMeasure);
+    m_textMeasureCacheHitCounter = metricsRecorder->createCounter(
+            Telemetry::AplMetricsRecorderInterface::LATEST_DOCUMENT,
+            Telemetry::AplRenderingSegment::kTextMeasureCacheHit);
+    m_textMeasureCacheMissCounter = metricsRecorder->createCounter(
+            Telemetry::AplMetricsRecorderInterface::LATEST_DOCUMENT,
+            Telemetry::AplRenderingSegment::kTextMeasureCacheMiss);
+}
+
+AplCoreTextMeasurement::AplCoreTextMeasurement(
+        AplCoreConnectionManagerPtr aplCoreConnectionManager,
+        AplConfigurationPtr config,
+        AplCoreMetricsPtr aplCoreMetrics,
+        const std::string& aplToken)
+    : AplCoreTextMeasurement(aplCoreConnectionManager, config) {
+    m_documentMetrics = aplCoreMetrics;
+    m_documentToken = aplToken;
+}
+
+void AplCoreTextMeasurement::setLive() {
+    m_documentMetrics.reset();
+    m_documentToken.clear();
+}
+
+AplCoreMetricsPtr AplCoreTextMeasurement::getAplCoreMetrics(
+        const AplCoreConnectionManagerPtr& aplCoreConnectionManager) const {
+    return m_documentMetrics ? m_documentMetrics : aplCoreConnectionManager->aplCoreMetrics();
+}
+
+std::string AplCoreTextMeasurement::getAPLToken(const AplCoreConnectionManagerPtr& aplCoreConnectionManager) const {
+    return m_documentMetrics ? m_documentToken : aplCoreConnectionManager->getAPLToken();
 }
 
 /**
@@ -53,9 +93,18 @@ AplCoreTextMeasurement::AplCoreTextMeasurement(
  *     { "type": "measure",
  *       "payload": {
  *           "width": FLOAT,
- *           "height": FLOAT
+ *           "height": FLOAT,
+ *           "baseline": FLOAT,
+ *           "lineCount": INT,
+ *           "lastLineWidth": FLOAT
  *     }}
  *
+ * The baseline, lineCount and lastLineWidth are optional. When present the baseline is answered locally for the
+ * measured size instead of with a separate baseline request.
+ *
+ * Results are cached by the measurement-relevant properties, constraints and modes, so a repeated request is
+ * answered without a viewhost round trip.
+ *
  * @param component
  * @param width
  * @param widthMode
@@ -73,53 +122,69 @@ apl::LayoutSize AplCoreTextMeasurement::measure(
     m_textMeasureCounter->increment();
     if (auto aplCoreConnectionManager = m_aplCoreConnectionManager.lock()) {
         /* Notify about the text measurement event */
-        aplOptions->onRenderingEvent(aplCoreConnectionManager->getAPLToken(), AplRenderingEvent::TEXT_MEASURE);
+        aplOptions->onRenderingEvent(getAPLToken(aplCoreConnectionManager), AplRenderingEvent::TEXT_MEASURE);
 
         auto msg = AplCoreViewhostMessage(MEASURE_KEY);
         auto& alloc = msg.alloc();
 
-        auto aplCoreMetrics = aplCoreConnectionManager->aplCoreMetrics();
+        auto aplCoreMetrics = getAplCoreMetrics(aplCoreConnectionManager);
+        auto viewhostWidth = aplCoreMetrics->toViewhost(std::isnan(width) ? (float)INT_MAX : width);
+        auto viewhostHeight = aplCoreMetrics->toViewhost(std::isnan(height) ? (float)INT_MAX : height);
 
         rapidjson::Value payload(component->serialize(alloc));
-        payload.AddMember("width", aplCoreMetrics->toViewhost(std::isnan(width) ? (float)INT_MAX : width), alloc);
-        payload.AddMember("height", aplCoreMetrics->toViewhost(std::isnan(height) ? (float)INT_MAX : height), alloc);
+        auto key = AplCoreTextMeasureCache::makeKey(payload, viewhostWidth, widthMode, viewhostHeight, heightMode);
+        AplCoreTextMeasureCache::Entry entry;
+        if (m_textMeasureCache->get(key, entry)) {
+            m_textMeasureCacheHitCounter->increment();
+            rememberBaseline(component, entry);
+            return {aplCoreMetrics->toCore(entry.width), aplCoreMetrics->toCore(entry.height)};
+        }
+        m_textMeasureCacheMissCounter->increment();
+        m_cacheMissCount++;
+
+        payload.AddMember("width", viewhostWidth, alloc);
+        payload.AddMember("height", viewhostHeight, alloc);
         payload.AddMember("widthMode", widthMode, alloc);
         payload.AddMember("heightMode", heightMode, alloc);
         msg.setPayload(std::move(payload));
 
         auto result = aplCoreConnectionManager->blockingSend(msg);
-        return this->GetValidMeasureResult(result, aplCoreMetrics.get());
+        if (GetValidMeasureResult(result, entry)) {
+            m_textMeasureCache->put(key, entry);
+            rememberBaseline(component, entry);
+            return {aplCoreMetrics->toCore(entry.width), aplCoreMetrics->toCore(entry.height)};
+        }
+
+        aplOptions->logMessage(LogLevel::WARN, __func__, "Didn't get a valid reply.  Returning generic size.");
+        return {aplCoreMetrics->toCore(100), aplCoreMetrics->toCore(100)};
     } else {
         aplOptions->logMessage(LogLevel::WARN, __func__, "ConnectionManager does not exist. Returning generic size.");
         return {0, 0};
     }
 }
 
-apl::LayoutSize AplCoreTextMeasurement::GetValidMeasureResult(rapidjson::Document& result, AplCoreMetrics* aplCoreMetrics) {
+void AplCoreTextMeasurement::rememberBaseline(apl::Component* component, const AplCoreTextMeasureCache::Entry& entry) {
+    if (entry.hasBaseline) {
+        if (m_measuredBaselines.size() >= MAX_MEASURED_BASELINES) {
+            m_measuredBaselines.clear();
+        }
+        m_measuredBaselines[component->getUniqueId()] = entry;
+    } else {
+        m_measuredBaselines.erase(component->getUniqueId());
+    }
+}
 
+bool AplCoreTextMeasurement::GetValidMeasureResult(
+        rapidjson::Document& result,
+        AplCoreTextMeasureCache::Entry& entry) {
     if (result.IsObject()) {
         auto payloadItr = result.FindMember("payload");
-            if (payloadItr != result.MemberEnd()) {
-            auto& payload = payloadItr->value;
-            auto widthItr = payload.FindMember("width");
-            auto heightItr = payload.FindMember("height");
-
-            if (widthItr != payload.MemberEnd() && heightItr != payload.MemberEnd()) {
-
-                auto& width = widthItr->value;
-                auto& height = heightItr->value;
-                if (width.IsNumber() && height.IsNumber()) {
-                    auto measuredWidth = aplCoreMetrics->toCore(width.GetFloat());
-                    auto measuredHeight = aplCoreMetrics->toCore(height.GetFloat());
-                    return {measuredWidth, measuredHeight};
-                }
-            }
+        if (payloadItr != result.MemberEnd()) {
+            return AplCoreTextMeasureCache::parseEntry(payloadItr->value, entry);
         }
     }
 
-    auto aplOptions = m_aplConfiguration->getAplOptions();
-    aplOptions->logMessage(LogLevel::WARN, __func__, "Didn't get a valid reply.  Returning generic size.");
-    return {aplCoreMetrics->toCore(100), aplCoreMetrics->toCore(100)};
+    return false;
 }
 
 /**
@@ -136,6 +201,8 @@ apl::LayoutSize AplCoreTextMeasurement::GetValidMeasureResult(rapidjson::Documen
  *     { "type": "baseline",
  *       "payload": FLOAT }
  *
+ * No message is sent if the measure reply for the component at this size already carried its baseline.
+ *
  * @param component
  * @param width
  * @param height
@@ -143,11 +210,19 @@ apl::LayoutSize AplCoreTextMeasurement::GetValidMeasureResult(rapidjson::Documen
  */
 float AplCoreTextMeasurement::baseline(apl::Component* component, float width, float height) {
     if (auto aplCoreConnectionManager = m_aplCoreConnectionManager.lock()) {
+        auto aplCoreMetrics = getAplCoreMetrics(aplCoreConnectionManager);
+
+        // Answer locally if the last measurement of this component returned a baseline for the same size
+        auto measured = m_measuredBaselines.find(component->getUniqueId());
+        if (measured != m_measuredBaselines.end() &&
+            std::abs(measured->second.width - aplCoreMetrics->toViewhost(width)) < BASELINE_SIZE_TOLERANCE &&
+            std::abs(measured->second.height - aplCoreMetrics->toViewhost(height)) < BASELINE_SIZE_TOLERANCE) {
+            return aplCoreMetrics->toCore(measured->second.baseline);
+        }
+
         auto msg = AplCoreViewhostMessage(BASELINE_KEY);
         auto& alloc = msg.alloc();
 
-        auto aplCoreMetrics = aplCoreConnectionManager->aplCoreMetrics();
-
         rapidjson::Value payload(rapidjson::kObjectType);
         payload.AddMember("id", rapidjson::Value(component->getUniqueId().c_str(), alloc).Move(), alloc);
         payload.AddMember("width", aplCoreMetrics->toViewhost(width), alloc);
@@ -0,0 +1,83 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+#include <new>
+
+#include "APLClient/AplCoreViewhostMessageArena.h"
+
+namespace APLClient {
+
+/// Room for the bookkeeping the allocator keeps in its buffer
+static const size_t ALLOCATOR_OVERHEAD = 256;
+
+AplCoreViewhostMessageArena::AplCoreViewhostMessageArena(size_t initialCapacity)
+    : m_buffer(initialCapacity),
+      m_allocator{nullptr},
+      m_inUse{false},
+      m_outputStream{m_output},
+      m_writer{m_outputStream} {
+}
+
+AplCoreViewhostMessageArena::~AplCoreViewhostMessageArena() {
+    if (m_allocator) {
+        m_allocator->~Allocator();
+    }
+}
+
+bool AplCoreViewhostMessageArena::acquire() {
+    if (m_inUse.exchange(true)) {
+        return false;
+    }
+
+    m_allocator = new (&m_allocatorStorage) Allocator(m_buffer.data(), m_buffer.size());
+    return true;
+}
+
+void AplCoreViewhostMessageArena::release() {
+    auto used = m_allocator->Size();
+    // Destroying the allocator frees any chunks allocated beyond the buffer
+    m_allocator->~Allocator();
+    m_allocator = nullptr;
+
+    // Grow the buffer so that a message of the same size fits next time
+    auto needed = used + ALLOCATOR_OVERHEAD;
+    if (needed > m_buffer.size() && needed <= MAX_RETAINED_CAPACITY) {
+        m_buffer.resize(needed + needed / 2);
+    }
+
+    if (m_output.capacity() > MAX_RETAINED_CAPACITY) {
+        std::string().swap(m_output);
+    }
+
+    m_inUse = false;
+}
+
+const std::string& AplCoreViewhostMessageArena::serialize(const rapidjson::Value& value) {
+    m_output.assign(HEADROOM, ' ');
+    m_writer.Reset(m_outputStream);
+    value.Accept(m_writer);
+    return m_output;
+}
+
+std::string AplCoreViewhostMessageArena::takeOutput() {
+    std::string output;
+    output.swap(m_output);
+    // The host keeps the taken buffer, start the next message with one of the same size
+    m_output.reserve(std::min(output.capacity(), MAX_RETAINED_CAPACITY));
+    return output;
+}
+
+}  // namespace APLClient
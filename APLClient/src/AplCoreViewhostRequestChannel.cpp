@@ -0,0 +1,133 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "APLClient/AplCoreViewhostRequestChannel.h"
+
+namespace APLClient {
+
+AplCoreViewhostRequestChannel::AplCoreViewhostRequestChannel() : m_pendingCount{0} {
+}
+
+AplCoreViewhostRequestChannel::~AplCoreViewhostRequestChannel() {
+    cancelAll();
+}
+
+void AplCoreViewhostRequestChannel::expect(
+        unsigned int seqno,
+        const Clock::time_point& deadline,
+        ReplyCallback callback) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_pending[seqno] = PendingRequest{deadline, std::move(callback)};
+    m_pendingCount = m_pending.size();
+}
+
+std::future<AplCoreViewhostInboundMessage> AplCoreViewhostRequestChannel::expect(
+        unsigned int seqno,
+        const Clock::time_point& deadline) {
+    auto promise = std::make_shared<std::promise<AplCoreViewhostInboundMessage>>();
+    auto future = promise->get_future();
+    expect(seqno, deadline, [promise](const AplCoreViewhostInboundMessage& reply) { promise->set_value(reply); });
+    return future;
+}
+
+bool AplCoreViewhostRequestChannel::resolve(const AplCoreViewhostInboundMessage& message) {
+    if (!message.hasSequenceNumber()) {
+        return false;
+    }
+
+    ReplyCallback callback;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        auto it = m_pending.find(message.getSequenceNumber());
+        if (it == m_pending.end()) {
+            return false;
+        }
+        callback = std::move(it->second.callback);
+        m_pending.erase(it);
+        m_pendingCount = m_pending.size();
+    }
+
+    // Invoked outside of the lock so that the callback may issue further requests
+    if (callback) {
+        callback(message);
+    }
+    return true;
+}
+
+bool AplCoreViewhostRequestChannel::cancel(unsigned int seqno) {
+    auto callbacks = take([seqno](unsigned int pendingSeqno, const PendingRequest&) { return pendingSeqno == seqno; });
+    for (auto& callback : callbacks) {
+        if (callback) {
+            callback(AplCoreViewhostInboundMessage());
+        }
+    }
+    return !callbacks.empty();
+}
+
+void AplCoreViewhostRequestChannel::cancelAll() {
+    auto callbacks = take([](unsigned int, const PendingRequest&) { return true; });
+    for (auto& callback : callbacks) {
+        if (callback) {
+            callback(AplCoreViewhostInboundMessage());
+        }
+    }
+}
+
+size_t AplCoreViewhostRequestChannel::expire(const Clock::time_point& now) {
+    if (!hasPending()) {
+        return 0;
+    }
+
+    auto callbacks = take([&now](unsigned int, const PendingRequest& request) { return request.deadline <= now; });
+    for (auto& callback : callbacks) {
+        if (callback) {
+            callback(AplCoreViewhostInboundMessage());
+        }
+    }
+    return callbacks.size();
+}
+
+AplCoreViewhostRequestChannel::Clock::time_point AplCoreViewhostRequestChannel::nextDeadline() {
+    if (!hasPending()) {
+        return Clock::time_point::max();
+    }
+
+    std::lock_guard<std::mutex> lock{m_mutex};
+    auto deadline = Clock::time_point::max();
+    for (auto& pending : m_pending) {
+        deadline = std::min(deadline, pending.second.deadline);
+    }
+    return deadline;
+}
+
+std::vector<AplCoreViewhostRequestChannel::ReplyCallback> AplCoreViewhostRequestChannel::take(
+        const std::function<bool(unsigned int, const PendingRequest&)>& predicate) {
+    std::vector<ReplyCallback> callbacks;
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (predicate(it->first, it->second)) {
+            callbacks.emplace_back(std::move(it->second.callback));
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_pendingCount = m_pending.size();
+    return callbacks;
+}
+
+}  // namespace APLClient
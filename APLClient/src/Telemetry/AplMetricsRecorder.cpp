@@ -27,7 +27,9 @@ static const std::map<AplRenderingSegment, std::string> sSegmentNames = {
     {AplRenderingSegment::kRenderDocument, "APLClient.renderDocument"},
     {AplRenderingSegment::kContentCreation, "APL-Web.Content.create"},
     {AplRenderingSegment::kRootContextInflation, "APL.rootContext.inflate"},
-    {AplRenderingSegment::kTextMeasure, "APL-Web.RootContext.measureCount"}
+    {AplRenderingSegment::kTextMeasure, "APL-Web.RootContext.measureCount"},
+    {AplRenderingSegment::kTextMeasureCacheHit, "APL-Web.RootContext.measureCacheHit"},
+    {AplRenderingSegment::kTextMeasureCacheMiss, "APL-Web.RootContext.measureCacheMiss"}
 };
 
 enum class MetricType { TIMER, COUNTER };
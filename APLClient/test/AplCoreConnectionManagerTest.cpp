@@ -14,10 +14,13 @@
  */
 
 #include "APLClient/AplCoreConnectionManager.h"
+#include "APLClient/AplCoreGuiRenderer.h"
 #include "MockAplOptionsInterface.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <APLClient/AplCoreTextMeasurement.h>
 #include <APLClient/Telemetry/NullAplMetricsRecorder.h>
@@ -582,7 +585,7 @@ TEST_F(AplCoreConnectionManagerTest, SetSupportedViewPortsSuccess) {
 /**
  * Tests BlockingSend function by setting a promise when sendMessage function
  * is called. If future is set correctly, shouldHandleMessage function should called.
- * shouldHandleMessage function sets m_replyPromise in the blockingSend function
+ * shouldHandleMessage function routes the reply to the request pending in the blockingSend function
  */
 TEST_F(AplCoreConnectionManagerTest, BlockingSendSuccess) {
     std::promise<bool> promise = std::promise<bool>();
@@ -617,6 +620,84 @@ TEST_F(AplCoreConnectionManagerTest, BlockingSendSuccess) {
     ASSERT_TRUE(result.IsObject());
 }
 
+/**
+ * Tests that several requests may be outstanding at once and that each reply is routed to its own request
+ * regardless of the order in which the replies arrive.
+ */
+TEST_F(AplCoreConnectionManagerTest, SendRequestOutOfOrderReplies) {
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).Times(Exactly(2));
+
+    auto firstMsg = AplCoreViewhostMessage("measure");
+    auto secondMsg = AplCoreViewhostMessage("measure");
+    auto first = m_aplCoreConnectionManager->sendRequest(firstMsg);
+    std::string secondReply;
+    auto secondSeqno = m_aplCoreConnectionManager->sendRequest(
+        secondMsg, [&secondReply](const AplCoreViewhostInboundMessage& reply) {
+            ASSERT_TRUE(reply.isValid());
+            secondReply = reply.getPayload()->GetString();
+        });
+    ASSERT_EQ(2u, secondSeqno);
+
+    ASSERT_FALSE(m_aplCoreConnectionManager->shouldHandleMessage(R"({"seqno": 2, "payload": "second"})"));
+    ASSERT_EQ("second", secondReply);
+    ASSERT_FALSE(m_aplCoreConnectionManager->shouldHandleMessage(R"({"seqno": 1, "payload": "first"})"));
+    ASSERT_EQ(std::future_status::ready, first.wait_for(std::chrono::milliseconds(0)));
+    ASSERT_STREQ("first", first.get().getPayload()->GetString());
+
+    // Nothing is pending any more so further messages are passed on for handling
+    ASSERT_TRUE(m_aplCoreConnectionManager->shouldHandleMessage(R"({"seqno": 1, "payload": "first"})"));
+}
+
+/**
+ * Tests that a host answering a request from within sendMessage may send again from the reply callback, as the
+ * message is handed to the host outside of the send lock.
+ */
+TEST_F(AplCoreConnectionManagerTest, SendsFromReplyCallbackOfSynchronousHost) {
+    auto* aplCoreConnectionManager = m_aplCoreConnectionManager.get();
+    std::vector<std::string> messages;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _))
+        .WillRepeatedly(Invoke([aplCoreConnectionManager, &messages](const std::string&, const std::string& payload) {
+            messages.push_back(payload);
+            rapidjson::Document request;
+            request.Parse(payload.c_str());
+            if (std::string(request["type"].GetString()) == "getFocused") {
+                aplCoreConnectionManager->shouldHandleMessage(
+                    "{\"seqno\":" + std::to_string(request["seqno"].GetInt()) + ",\"payload\":{}}");
+            }
+        }));
+
+    auto request = AplCoreViewhostMessage("getFocused");
+    bool replied = false;
+    m_aplCoreConnectionManager->sendRequest(
+        request, [aplCoreConnectionManager, &replied](const AplCoreViewhostInboundMessage& reply) {
+            replied = reply.isValid();
+            auto followUp = AplCoreViewhostMessage("followUp");
+            aplCoreConnectionManager->send(followUp);
+        });
+
+    ASSERT_TRUE(replied);
+    ASSERT_EQ(2u, messages.size());
+    ASSERT_NE(std::string::npos, messages[0].find("getFocused"));
+    ASSERT_NE(std::string::npos, messages[1].find("followUp"));
+}
+
+TEST_F(AplCoreConnectionManagerTest, NextTickTimeFollowsPendingRequests) {
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).Times(Exactly(1));
+
+    // Without a document or outstanding requests there is nothing to tick for
+    ASSERT_EQ(std::chrono::steady_clock::time_point::max(), m_aplCoreConnectionManager->getNextTickTime());
+
+    auto msg = AplCoreViewhostMessage("measure");
+    auto before = std::chrono::steady_clock::now();
+    auto reply = m_aplCoreConnectionManager->sendRequest(msg, std::chrono::milliseconds(1000));
+    auto next = m_aplCoreConnectionManager->getNextTickTime();
+    ASSERT_LE(before + std::chrono::milliseconds(1000), next);
+    ASSERT_GE(std::chrono::steady_clock::now() + std::chrono::milliseconds(1000), next);
+
+    ASSERT_FALSE(m_aplCoreConnectionManager->shouldHandleMessage(R"({"seqno": 1, "payload": "reply"})"));
+    ASSERT_EQ(std::chrono::steady_clock::time_point::max(), m_aplCoreConnectionManager->getNextTickTime());
+}
+
 TEST_F(AplCoreConnectionManagerTest, HandleDynamicDataSource) {
     EXPECT_CALL(*m_mockAplOptions, resetViewhost(_)).Times(1);
     EXPECT_CALL(*m_mockAplOptions, onRenderingEvent(_, _)).Times(2);
@@ -1047,6 +1128,772 @@ TEST_F(AplCoreConnectionManagerTest, HandleReHierarchySuccess) {
     m_aplCoreConnectionManager->handleMessage(payload);
 }
 
+static const std::string BUILD_PAYLOAD_WITH_DOCUMENT_SWAP =
+    "{"
+    "  \"type\":\"build\","
+    "  \"payload\":"
+    "  {"
+    "    \"width\":1920,\"height\":1080,"
+    "    \"shape\":\"RECTANGLE\","
+    "    \"dpi\":160,"
+    "    \"mode\":\"TV\","
+    "    \"supportsDocumentSwap\":true"
+    "  }"
+    "}";
+
+static const std::string DOCUMENT_FRAME =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Frame\","
+    "      \"width\": \"100%\","
+    "      \"height\": \"100%\""
+    "    }"
+    "  }"
+    "}";
+
+/**
+ * Test that a viewhost supporting document swap keeps the current document live while the next one is inflated,
+ * and receives the next hierarchy without being reset.
+ */
+TEST_F(AplCoreConnectionManagerTest, SwapsStagedDocumentWithoutReset) {
+    SetupMocksForDocumentRender();
+    BuildDocument(DOCUMENT, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_DOCUMENT_SWAP);
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    EXPECT_CALL(*m_mockAplOptions, resetViewhost(_)).Times(0);
+    const std::string hierarchyMessageType = "\"type\":\"hierarchy\"";
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).Times(AnyNumber());
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage(hierarchyMessageType, ""))).Times(1);
+    EXPECT_CALL(*m_mockAplOptions, onRenderDocumentComplete("next", true, _)).Times(1);
+
+    auto content = apl::Content::create(DOCUMENT_FRAME);
+    ASSERT_TRUE(content->isReady());
+    m_aplCoreConnectionManager->setContent(content, "next");
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (m_aplCoreConnectionManager->getAPLToken() != "next" && std::chrono::steady_clock::now() < deadline) {
+        m_aplCoreConnectionManager->onUpdateTick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ("next", m_aplCoreConnectionManager->getAPLToken());
+}
+
+/**
+ * Test that a document rendered again with the same data and viewports is restored from the document cache, and is
+ * inflated again when the viewhost configuration has changed.
+ */
+TEST_F(AplCoreConnectionManagerTest, RestoresCachedDocument) {
+    SetupMocksForDocumentRender();
+    auto documentKey = AplCoreDocumentCache::makeDocumentKey(DOCUMENT, DATA, VIEWPORT);
+    m_aplCoreConnectionManager->setDocumentCacheSize(2);
+    ASSERT_TRUE(m_aplCoreConnectionManager->isDocumentCacheEnabled());
+    ASSERT_FALSE(m_aplCoreConnectionManager->restoreCachedDocument(documentKey, "first"));
+    m_aplCoreConnectionManager->prepareContent(documentKey, {});
+    BuildDocument(DOCUMENT, DATA, VIEWPORT, BUILD_PAYLOAD);
+    auto root = m_aplCoreConnectionManager->getActiveDocumentState()->rootContext;
+
+    auto otherKey = AplCoreDocumentCache::makeDocumentKey(DOCUMENT, "{\"other\": 1}", VIEWPORT);
+    ASSERT_FALSE(m_aplCoreConnectionManager->restoreCachedDocument(otherKey, "other"));
+
+    EXPECT_CALL(*m_mockAplOptions, resetViewhost("second")).Times(1);
+    EXPECT_CALL(*m_mockAplOptions, onRenderDocumentComplete("second", true, _)).Times(1);
+    ASSERT_TRUE(m_aplCoreConnectionManager->restoreCachedDocument(documentKey, "second"));
+    m_aplCoreConnectionManager->handleMessage(BUILD_PAYLOAD);
+    ASSERT_EQ("second", m_aplCoreConnectionManager->getAPLToken());
+    ASSERT_EQ(root, m_aplCoreConnectionManager->getActiveDocumentState()->rootContext);
+
+    // A build for another configuration inflates the cached content again
+    ASSERT_TRUE(m_aplCoreConnectionManager->restoreCachedDocument(documentKey, "third"));
+    m_aplCoreConnectionManager->handleMessage(BUILD_PAYLOAD_WITH_DOCUMENT_SWAP);
+    ASSERT_EQ("third", m_aplCoreConnectionManager->getAPLToken());
+    ASSERT_NE(root, m_aplCoreConnectionManager->getActiveDocumentState()->rootContext);
+}
+
+static const std::string DOCUMENT_LIVE =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"parameters\": [\"payload\"],"
+    "    \"items\": {"
+    "      \"type\": \"Frame\","
+    "      \"id\": \"liveFrame\","
+    "      \"backgroundColor\": \"${payload.data.color}\""
+    "    }"
+    "  }"
+    "}";
+
+/**
+ * Test that rendering the displayed document again with new data updates it in place when data-only renders are
+ * enabled, and that a change to an array still renders a new document.
+ */
+TEST_F(AplCoreConnectionManagerTest, RenderDataOnlyUpdatesLiveDocument) {
+    SetupMocksForDocumentRender();
+    AplCoreGuiRenderer renderer(m_aplConfiguration, m_aplCoreConnectionManager);
+    renderer.setDataOnlyRenderEnabled(true);
+    renderer.renderDocument(DOCUMENT_LIVE, "{\"data\": {\"color\": \"red\", \"list\": [1]}}", VIEWPORT, "first");
+    m_aplCoreConnectionManager->handleMessage(BUILD_PAYLOAD);
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    EXPECT_CALL(*m_mockAplOptions, resetViewhost(_)).Times(0);
+    EXPECT_CALL(*m_mockAplOptions, onRenderDocumentComplete("second", true, _)).Times(1);
+    renderer.renderDocument(DOCUMENT_LIVE, "{\"data\": {\"color\": \"blue\", \"list\": [1]}}", VIEWPORT, "second");
+    ASSERT_EQ("second", m_aplCoreConnectionManager->getAPLToken());
+
+    const std::string dirtyMessageType = "\"type\":\"dirty\"";
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).Times(AnyNumber());
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage(dirtyMessageType, ""))).Times(AtLeast(1));
+    m_aplCoreConnectionManager->onUpdateTick();
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    EXPECT_CALL(*m_mockAplOptions, resetViewhost("third")).Times(1);
+    renderer.renderDocument(DOCUMENT_LIVE, "{\"data\": {\"color\": \"blue\", \"list\": [2]}}", VIEWPORT, "third");
+}
+
+static const std::string DOCUMENT_LIVE_WITH_STRING =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"parameters\": [\"data\", \"title\"],"
+    "    \"items\": {"
+    "      \"type\": \"Frame\","
+    "      \"id\": \"${title}\","
+    "      \"backgroundColor\": \"${data.color}\""
+    "    }"
+    "  }"
+    "}";
+
+/**
+ * Test that a change to a parameter which is not bound to an object renders a new document, even when data-only
+ * renders are enabled.
+ */
+TEST_F(AplCoreConnectionManagerTest, RenderDataOnlyRejectsChangedStaticParameter) {
+    SetupMocksForDocumentRender();
+    AplCoreGuiRenderer renderer(m_aplConfiguration, m_aplCoreConnectionManager);
+    renderer.setDataOnlyRenderEnabled(true);
+    renderer.renderDocument(
+        DOCUMENT_LIVE_WITH_STRING, "{\"data\": {\"color\": \"red\"}, \"title\": \"one\"}", VIEWPORT, "first");
+    m_aplCoreConnectionManager->handleMessage(BUILD_PAYLOAD);
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    EXPECT_CALL(*m_mockAplOptions, resetViewhost(_)).Times(0);
+    renderer.renderDocument(
+        DOCUMENT_LIVE_WITH_STRING, "{\"data\": {\"color\": \"blue\"}, \"title\": \"one\"}", VIEWPORT, "second");
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    EXPECT_CALL(*m_mockAplOptions, resetViewhost("third")).Times(1);
+    renderer.renderDocument(
+        DOCUMENT_LIVE_WITH_STRING, "{\"data\": {\"color\": \"blue\"}, \"title\": \"two\"}", VIEWPORT, "third");
+}
+
+static const std::string DOCUMENT_LIVE_ARRAY =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Container\","
+    "      \"items\": ["
+    "        {"
+    "          \"type\": \"Container\","
+    "          \"id\": \"list\","
+    "          \"data\": \"${items}\","
+    "          \"items\": { \"type\": \"Frame\", \"width\": 10, \"height\": 10 }"
+    "        },"
+    "        {"
+    "          \"type\": \"Container\","
+    "          \"id\": \"unchanged\","
+    "          \"items\": [ { \"type\": \"Frame\" }, { \"type\": \"Frame\" } ]"
+    "        }"
+    "      ]"
+    "    }"
+    "  }"
+    "}";
+
+/**
+ * Test that an inserted child only sends the displayed children of the components which changed.
+ */
+TEST_F(AplCoreConnectionManagerTest, InsertSendsChangedDisplayedChildrenOnly) {
+    SetupMocksForDocumentRender();
+    auto items = apl::LiveArray::create(apl::ObjectArray{1, 2});
+    m_aplCoreConnectionManager->prepareContent(AplCoreDocumentCache::Key(), {{"items", items}});
+    BuildDocument(DOCUMENT_LIVE_ARRAY, DATA, VIEWPORT, BUILD_PAYLOAD);
+    auto root = m_aplCoreConnectionManager->getActiveDocumentState()->rootContext;
+    auto list = root->findComponentById("list");
+    auto unchanged = root->findComponentById("unchanged");
+    ASSERT_TRUE(list && unchanged);
+
+    std::vector<std::string> messages;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).WillRepeatedly(Invoke(
+        [&messages](const std::string&, const std::string& payload) { messages.push_back(payload); }));
+    items->push_back(3);
+    m_aplCoreConnectionManager->onUpdateTick();
+
+    std::string dirty;
+    for (const auto& message : messages) {
+        if (message.find("\"type\":\"dirty\"") != std::string::npos) {
+            dirty = message;
+        }
+    }
+    ASSERT_NE(std::string::npos, dirty.find("displayedChildrenHierarchy"));
+    ASSERT_NE(std::string::npos, dirty.find("\"" + list->getUniqueId() + "\":["));
+    ASSERT_EQ(std::string::npos, dirty.find("\"" + unchanged->getUniqueId() + "\":["));
+}
+
+static const std::string BUILD_PAYLOAD_WITH_HIERARCHY_DIFF =
+    "{"
+    "  \"type\":\"build\","
+    "  \"payload\":"
+    "  {"
+    "    \"width\":1920,\"height\":1080,"
+    "    \"shape\":\"RECTANGLE\","
+    "    \"dpi\":160,"
+    "    \"mode\":\"TV\","
+    "    \"supportsHierarchyDiff\":true"
+    "  }"
+    "}";
+
+/**
+ * Test that a viewhost supporting hierarchy diffs receives a reinflated hierarchy as a diff.
+ */
+TEST_F(AplCoreConnectionManagerTest, ReInflateSendsHierarchyDiff) {
+    SetupMocksForDocumentRender();
+    BuildDocument(DOCUMENT, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_HIERARCHY_DIFF);
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    std::string hierarchy;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage("\"type\":\"hierarchy\"", "")))
+        .WillOnce(Invoke([&hierarchy](const std::string&, const std::string& payload) { hierarchy = payload; }));
+    m_aplCoreConnectionManager->handleMessage("{\"type\":\"reInflate\",\"payload\":{}}");
+
+    ASSERT_NE(std::string::npos, hierarchy.find("\"diff\":{"));
+    ASSERT_EQ(std::string::npos, hierarchy.find("\"hierarchy\":{"));
+    ASSERT_NE(std::string::npos, hierarchy.find("displayedChildrenHierarchy"));
+}
+
+static const std::string BUILD_PAYLOAD_WITH_VIRTUALIZED_HIERARCHY =
+    "{"
+    "  \"type\":\"build\","
+    "  \"payload\":"
+    "  {"
+    "    \"width\":1920,\"height\":1080,"
+    "    \"shape\":\"RECTANGLE\","
+    "    \"dpi\":160,"
+    "    \"mode\":\"TV\","
+    "    \"supportsVirtualizedHierarchy\":true,"
+    "    \"virtualizationMargin\":0"
+    "  }"
+    "}";
+
+static const std::string DOCUMENT_LONG_SEQUENCE =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Sequence\","
+    "      \"id\": \"list\","
+    "      \"width\": \"100%\","
+    "      \"height\": \"100%\","
+    "      \"data\": [1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20],"
+    "      \"items\": {"
+    "        \"type\": \"Frame\","
+    "        \"width\": \"100%\","
+    "        \"height\": 500"
+    "      }"
+    "    }"
+    "  }"
+    "}";
+
+/**
+ * Test that a viewhost supporting a virtualized hierarchy receives off-screen Sequence items as placeholders, and
+ * receives them in full when it asks to materialize them.
+ */
+TEST_F(AplCoreConnectionManagerTest, VirtualizedHierarchySendsPlaceholders) {
+    SetupMocksForDocumentRender();
+    std::string hierarchy;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage("\"type\":\"hierarchy\"", "")))
+        .WillOnce(Invoke([&hierarchy](const std::string&, const std::string& payload) { hierarchy = payload; }));
+    BuildDocument(DOCUMENT_LONG_SEQUENCE, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_VIRTUALIZED_HIERARCHY);
+
+    auto list = m_aplCoreConnectionManager->getActiveDocumentState()->rootContext->findComponentById("list");
+    ASSERT_TRUE(list);
+    auto first = list->getChildAt(0)->getUniqueId();
+    auto last = list->getChildAt(list->getChildCount() - 1)->getUniqueId();
+    // The first item is in view and sent in full, the last one is a placeholder
+    auto firstAt = hierarchy.find("\"id\":\"" + first + "\"");
+    auto lastAt = hierarchy.find("\"id\":\"" + last + "\"");
+    ASSERT_NE(std::string::npos, firstAt);
+    ASSERT_NE(std::string::npos, lastAt);
+    ASSERT_EQ(std::string::npos, hierarchy.substr(firstAt, 64).find("\"placeholder\":true"));
+    ASSERT_NE(std::string::npos, hierarchy.substr(lastAt, 64).find("\"placeholder\":true"));
+
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    std::string materialized;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage("\"type\":\"materialize\"", "")))
+        .WillOnce(Invoke([&materialized](const std::string&, const std::string& payload) { materialized = payload; }));
+    m_aplCoreConnectionManager->handleMessage(
+        "{\"type\":\"materialize\",\"payload\":{\"components\":[\"" + last + "\"]}}");
+    ASSERT_NE(std::string::npos, materialized.find("\"id\":\"" + last + "\""));
+    ASSERT_EQ(std::string::npos, materialized.find("\"placeholder\""));
+}
+
+static const std::string DOCUMENT_HIDDEN_PANEL =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Container\","
+    "      \"width\": \"100%\","
+    "      \"height\": \"100%\","
+    "      \"items\": {"
+    "        \"type\": \"Frame\","
+    "        \"id\": \"panel\","
+    "        \"display\": \"none\","
+    "        \"item\": {"
+    "          \"type\": \"Text\","
+    "          \"id\": \"label\","
+    "          \"text\": \"before\""
+    "        }"
+    "      }"
+    "    }"
+    "  }"
+    "}";
+
+static std::string setValueCommand(const std::string& componentId, const std::string& property, const std::string& value) {
+    return "{\"commands\": [{\"type\": \"SetValue\", \"componentId\": \"" + componentId +
+           "\", \"property\": \"" + property + "\", \"value\": \"" + value + "\"}]}";
+}
+
+/**
+ * Test that the dirty properties of a hidden component are held, and sent with their latest value once it is shown.
+ */
+TEST_F(AplCoreConnectionManagerTest, HoldsDirtyUpdatesOfHiddenComponents) {
+    SetupMocksForDocumentRender();
+    BuildDocument(DOCUMENT_HIDDEN_PANEL, DATA, VIEWPORT);
+    auto label = m_aplCoreConnectionManager->getActiveDocumentState()->rootContext->findComponentById("label");
+    ASSERT_TRUE(label);
+    const std::string labelId = "\"id\":\"" + label->getUniqueId() + "\"";
+
+    std::vector<std::string> messages;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).WillRepeatedly(Invoke(
+        [&messages](const std::string&, const std::string& payload) { messages.push_back(payload); }));
+    m_aplCoreConnectionManager->executeCommands(setValueCommand("label", "text", "first"), "");
+    m_aplCoreConnectionManager->onUpdateTick();
+    m_aplCoreConnectionManager->executeCommands(setValueCommand("label", "text", "second"), "");
+    m_aplCoreConnectionManager->onUpdateTick();
+    for (const auto& message : messages) {
+        ASSERT_EQ(std::string::npos, message.find(labelId));
+    }
+
+    messages.clear();
+    m_aplCoreConnectionManager->executeCommands(setValueCommand("panel", "display", "normal"), "");
+    m_aplCoreConnectionManager->onUpdateTick();
+    std::string dirty;
+    for (const auto& message : messages) {
+        if (message.find("\"type\":\"dirty\"") != std::string::npos) {
+            dirty = message;
+        }
+    }
+    ASSERT_NE(std::string::npos, dirty.find(labelId));
+    ASSERT_NE(std::string::npos, dirty.find("second"));
+    ASSERT_EQ(std::string::npos, dirty.find("first"));
+}
+
+static const std::string DOCUMENT_LIVE_TEXT =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Container\","
+    "      \"items\": {"
+    "        \"type\": \"Text\","
+    "        \"id\": \"liveText\","
+    "        \"text\": \"Live\""
+    "      }"
+    "    }"
+    "  }"
+    "}";
+
+static const std::string DOCUMENT_STAGED_TEXTS =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Container\","
+    "      \"data\": \"${Array.range(50)}\","
+    "      \"items\": {"
+    "        \"type\": \"Text\","
+    "        \"text\": \"Staged ${data}\""
+    "      }"
+    "    }"
+    "  }"
+    "}";
+
+/**
+ * Test that the live document keeps laying out text while the next document is inflated, and that the text of the
+ * staged document is measured for the staged document rather than for the live one.
+ */
+TEST_F(AplCoreConnectionManagerTest, StagedDocumentMeasuresTextApartFromLiveDocument) {
+    SetupMocksForDocumentRender();
+    auto* aplCoreConnectionManager = m_aplCoreConnectionManager.get();
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage("\"type\":\"measure\"", "")))
+        .WillRepeatedly(Invoke([aplCoreConnectionManager](const std::string&, const std::string& payload) {
+            rapidjson::Document request;
+            request.Parse(payload.c_str());
+            aplCoreConnectionManager->shouldHandleMessage(
+                "{\"type\":\"measure\",\"seqno\":" + std::to_string(request["seqno"].GetInt()) +
+                ",\"payload\":{\"width\":100,\"height\":40}}");
+        }));
+    BuildDocument(DOCUMENT_LIVE_TEXT, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_DOCUMENT_SWAP);
+
+    auto testThread = std::this_thread::get_id();
+    std::atomic<int> liveMeasures{0};
+    std::atomic<int> stagedMeasures{0};
+    std::atomic<bool> stagedMeasuredForLiveToken{false};
+    EXPECT_CALL(*m_mockAplOptions, onRenderingEvent(_, _))
+        .WillRepeatedly(Invoke([&](const std::string& token, AplRenderingEvent event) {
+            if (event != AplRenderingEvent::TEXT_MEASURE) {
+                return;
+            }
+            if (std::this_thread::get_id() == testThread) {
+                liveMeasures++;
+                return;
+            }
+            stagedMeasures++;
+            if (token != "next") {
+                stagedMeasuredForLiveToken = true;
+            }
+            // Hold the inflation until the live document has measured text too, so that both measure at once
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (liveMeasures == 0 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }));
+
+    auto content = apl::Content::create(DOCUMENT_STAGED_TEXTS);
+    ASSERT_TRUE(content->isReady());
+    m_aplCoreConnectionManager->setContent(content, "next");
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    for (int i = 0; m_aplCoreConnectionManager->getAPLToken() != "next" && std::chrono::steady_clock::now() < deadline;
+         i++) {
+        m_aplCoreConnectionManager->executeCommands(setValueCommand("liveText", "text", "Live " + std::to_string(i)), "");
+        m_aplCoreConnectionManager->onUpdateTick();
+    }
+    ASSERT_EQ("next", m_aplCoreConnectionManager->getAPLToken());
+    ASSERT_LT(0, liveMeasures.load());
+    ASSERT_LT(0, stagedMeasures.load());
+    ASSERT_FALSE(stagedMeasuredForLiveToken.load());
+}
+
+/**
+ * Test that a staged document which is superseded while it is being inflated is dropped without waiting for its
+ * inflation to complete.
+ */
+TEST_F(AplCoreConnectionManagerTest, DropsSupersededStagedDocumentWithoutWaiting) {
+    SetupMocksForDocumentRender();
+    auto* aplCoreConnectionManager = m_aplCoreConnectionManager.get();
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage("\"type\":\"measure\"", "")))
+        .WillRepeatedly(Invoke([aplCoreConnectionManager](const std::string&, const std::string& payload) {
+            rapidjson::Document request;
+            request.Parse(payload.c_str());
+            aplCoreConnectionManager->shouldHandleMessage(
+                "{\"type\":\"measure\",\"seqno\":" + std::to_string(request["seqno"].GetInt()) +
+                ",\"payload\":{\"width\":100,\"height\":40}}");
+        }));
+    BuildDocument(DOCUMENT_LIVE_TEXT, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_DOCUMENT_SWAP);
+
+    // Hold the inflation of the first staged document until it has been superseded
+    auto testThread = std::this_thread::get_id();
+    std::atomic<bool> superseded{false};
+    EXPECT_CALL(*m_mockAplOptions, onRenderingEvent(_, _))
+        .WillRepeatedly(Invoke([&](const std::string&, AplRenderingEvent event) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (event == AplRenderingEvent::TEXT_MEASURE && std::this_thread::get_id() != testThread &&
+                   !superseded && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }));
+
+    auto first = apl::Content::create(DOCUMENT_STAGED_TEXTS);
+    ASSERT_TRUE(first->isReady());
+    m_aplCoreConnectionManager->setContent(first, "first");
+
+    auto start = std::chrono::steady_clock::now();
+    auto second = apl::Content::create(DOCUMENT_FRAME);
+    ASSERT_TRUE(second->isReady());
+    m_aplCoreConnectionManager->setContent(second, "second");
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    superseded = true;
+    ASSERT_LT(elapsed, std::chrono::seconds(1));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while ((m_aplCoreConnectionManager->getAPLToken() != "second" || first.use_count() > 1) &&
+           std::chrono::steady_clock::now() < deadline) {
+        m_aplCoreConnectionManager->onUpdateTick();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ("second", m_aplCoreConnectionManager->getAPLToken());
+    // The first inflation has completed and released its content
+    ASSERT_EQ(1, first.use_count());
+}
+
+static const std::string BUILD_PAYLOAD_WITH_MEASURE_BATCH =
+    "{"
+    "  \"type\":\"build\","
+    "  \"payload\":"
+    "  {"
+    "    \"width\":1920,\"height\":1080,"
+    "    \"shape\":\"RECTANGLE\","
+    "    \"dpi\":160,"
+    "    \"mode\":\"TV\","
+    "    \"supportsMeasureBatch\":true"
+    "  }"
+    "}";
+
+/**
+ * Test that a viewhost supporting batched measurement receives the text measurements of a document in one
+ * measureBatch message ahead of its hierarchy, and that the reply primes the text measurement cache.
+ */
+TEST_F(AplCoreConnectionManagerTest, PremeasuresTextInOneBatch) {
+    SetupMocksForDocumentRender();
+    auto* aplCoreConnectionManager = m_aplCoreConnectionManager.get();
+    size_t requested = 0;
+    bool hierarchySent = false;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage("\"type\":\"hierarchy\"", "")))
+        .WillOnce(Invoke([&hierarchySent](const std::string&, const std::string&) { hierarchySent = true; }));
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage("\"type\":\"measureBatch\"", "")))
+        .WillOnce(Invoke([aplCoreConnectionManager, &requested, &hierarchySent](
+                             const std::string&, const std::string& payload) {
+            ASSERT_FALSE(hierarchySent);
+            rapidjson::Document request;
+            request.Parse(payload.c_str());
+            requested = request["payload"].Size();
+            std::string results;
+            for (size_t i = 0; i < requested; i++) {
+                results += (i ? "," : "") + std::string("{\"width\":400,\"height\":40}");
+            }
+            aplCoreConnectionManager->shouldHandleMessage(
+                "{\"type\":\"measureBatch\",\"seqno\":" + std::to_string(request["seqno"].GetInt()) +
+                ",\"payload\":[" + results + "]}");
+        }));
+
+    BuildDocument(DOCUMENT, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_MEASURE_BATCH);
+
+    ASSERT_TRUE(hierarchySent);
+    ASSERT_LT(0u, requested);
+    ASSERT_LE(requested, m_aplConfiguration->getTextMeasureCache()->size());
+}
+
+/**
+ * Test that a document whose last inflation measured all of its text from the cache is inflated again without a
+ * measureBatch dry run.
+ */
+TEST_F(AplCoreConnectionManagerTest, SkipsPremeasureOfDocumentMeasuredFromCache) {
+    SetupMocksForDocumentRender();
+    auto* aplCoreConnectionManager = m_aplCoreConnectionManager.get();
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, MatchOutMessage("\"type\":\"measureBatch\"", "")))
+        .WillOnce(Invoke([aplCoreConnectionManager](const std::string&, const std::string& payload) {
+            rapidjson::Document request;
+            request.Parse(payload.c_str());
+            std::string results;
+            for (size_t i = 0; i < request["payload"].Size(); i++) {
+                results += (i ? "," : "") + std::string("{\"width\":400,\"height\":40}");
+            }
+            aplCoreConnectionManager->shouldHandleMessage(
+                "{\"type\":\"measureBatch\",\"seqno\":" + std::to_string(request["seqno"].GetInt()) +
+                ",\"payload\":[" + results + "]}");
+        }));
+
+    auto documentKey = AplCoreDocumentCache::makeUncachedDocumentKey(DOCUMENT, DATA, VIEWPORT);
+    ASSERT_TRUE(documentKey.empty());
+    m_aplCoreConnectionManager->prepareContent(documentKey, {});
+    BuildDocument(DOCUMENT, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_MEASURE_BATCH);
+
+    m_aplCoreConnectionManager->prepareContent(documentKey, {});
+    BuildDocument(DOCUMENT, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_MEASURE_BATCH);
+    ASSERT_TRUE(m_aplCoreConnectionManager->getActiveDocumentState());
+}
+
+static const std::string BUILD_PAYLOAD_WITH_FRAME_BATCH =
+    "{"
+    "  \"type\":\"build\","
+    "  \"payload\":"
+    "  {"
+    "    \"allowOpenUrl\":true,"
+    "    \"width\":1920,\"height\":1080,"
+    "    \"shape\":\"RECTANGLE\","
+    "    \"dpi\":160,"
+    "    \"mode\":\"TV\","
+    "    \"supportsFrameBatch\":true"
+    "  }"
+    "}";
+
+static const std::string DOCUMENT_BOX =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Frame\","
+    "      \"id\": \"box\","
+    "      \"width\": \"100%\","
+    "      \"height\": \"100%\""
+    "    }"
+    "  }"
+    "}";
+
+/// Sends an event to the viewhost, one to the host and changes a property within the same frame
+static const std::string FRAME_COMMANDS =
+    "{\"commands\": [{\"type\": \"Parallel\", \"commands\": ["
+    "  {\"type\": \"OpenURL\", \"source\": \"https://example.com\"},"
+    "  {\"type\": \"SendEvent\", \"arguments\": [\"frame\"]},"
+    "  {\"type\": \"SetValue\", \"componentId\": \"box\", \"property\": \"opacity\", \"value\": 0.5}"
+    "]}]}";
+
+/**
+ * @return The sequence numbers of a sent message, or of each message of a frame batch, in order
+ */
+static std::vector<int> getSequenceNumbers(const std::string& payload) {
+    rapidjson::Document message;
+    message.Parse(payload.c_str());
+    std::vector<int> seqnos;
+    if (std::string(message["type"].GetString()) == "frameBatch") {
+        for (const auto& entry : message["payload"].GetArray()) {
+            seqnos.push_back(entry[SEQNO_KEY.c_str()].GetInt());
+        }
+    } else {
+        seqnos.push_back(message[SEQNO_KEY.c_str()].GetInt());
+    }
+    return seqnos;
+}
+
+/**
+ * @return true if the sequence numbers of the sent messages increase in the order the messages were sent
+ */
+static bool isInSequence(const std::vector<std::string>& messages) {
+    int last = 0;
+    for (const auto& message : messages) {
+        for (auto seqno : getSequenceNumbers(message)) {
+            if (seqno <= last) {
+                return false;
+            }
+            last = seqno;
+        }
+    }
+    return true;
+}
+
+/**
+ * Test that a viewhost supporting frame batches receives the messages of a frame in one envelope, in sequence
+ * number order.
+ */
+TEST_F(AplCoreConnectionManagerTest, SendsOneFrameBatchPerTick) {
+    SetupMocksForDocumentRender();
+    BuildDocument(DOCUMENT_BOX, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_FRAME_BATCH);
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    std::vector<std::string> messages;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).WillRepeatedly(Invoke(
+        [&messages](const std::string&, const std::string& payload) { messages.push_back(payload); }));
+    m_aplCoreConnectionManager->executeCommands(FRAME_COMMANDS, "");
+    m_aplCoreConnectionManager->onUpdateTick();
+
+    ASSERT_EQ(1u, messages.size());
+    ASSERT_NE(std::string::npos, messages[0].find("\"type\":\"frameBatch\""));
+    ASSERT_LE(2u, getSequenceNumbers(messages[0]).size());
+    ASSERT_TRUE(isInSequence(messages));
+}
+
+/**
+ * Test that a request sent in the middle of a frame goes out after the messages batched before it, and that the
+ * messages of the frame keep their sequence number order.
+ */
+TEST_F(AplCoreConnectionManagerTest, RequestFlushesFrameBatch) {
+    SetupMocksForDocumentRender();
+    BuildDocument(DOCUMENT_BOX, DATA, VIEWPORT, BUILD_PAYLOAD_WITH_FRAME_BATCH);
+    Mock::VerifyAndClearExpectations(m_mockAplOptions.get());
+
+    std::vector<std::string> messages;
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).WillRepeatedly(Invoke(
+        [&messages](const std::string&, const std::string& payload) { messages.push_back(payload); }));
+    auto* aplCoreConnectionManager = m_aplCoreConnectionManager.get();
+    EXPECT_CALL(*m_mockAplOptions, onSendEvent(_, _)).WillOnce(InvokeWithoutArgs([aplCoreConnectionManager] {
+        auto request = AplCoreViewhostMessage("getFocused");
+        aplCoreConnectionManager->sendRequest(request, std::chrono::milliseconds(100));
+    }));
+    m_aplCoreConnectionManager->executeCommands(FRAME_COMMANDS, "");
+    m_aplCoreConnectionManager->onUpdateTick();
+
+    auto request = std::find_if(messages.begin(), messages.end(), [](const std::string& message) {
+        return message.find("\"type\":\"getFocused\"") != std::string::npos;
+    });
+    ASSERT_NE(messages.end(), request);
+    ASSERT_EQ(std::string::npos, request->find("\"type\":\"frameBatch\""));
+    ASSERT_NE(std::string::npos, messages.back().find("\"type\":\"dirty\""));
+    ASSERT_TRUE(isInSequence(messages));
+}
+
+/**
+ * Options which take over the messages handed over with transferMessage, which the default forwards to sendMessage
+ */
+class TransferringAplOptions : public MockAplOptionsInterface {
+public:
+    void transferMessage(const std::string& token, std::string&& payload) override {
+        transferred.push_back(std::move(payload));
+    }
+
+    /// The messages handed over, in order
+    std::vector<std::string> transferred;
+};
+
+static const std::string DOCUMENT_MANY_FRAMES =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Container\","
+    "      \"width\": \"100%\","
+    "      \"height\": \"100%\","
+    "      \"data\": \"${Array.range(200)}\","
+    "      \"items\": {"
+    "        \"type\": \"Frame\","
+    "        \"width\": 10,"
+    "        \"height\": 10"
+    "      }"
+    "    }"
+    "  }"
+    "}";
+
+/**
+ * Test that a large message is handed over to the host with transferMessage rather than copied with sendMessage.
+ */
+TEST_F(AplCoreConnectionManagerTest, TransfersLargeMessages) {
+    auto aplOptions = std::make_shared<NiceMock<TransferringAplOptions>>();
+    m_mockAplOptions = aplOptions;
+    m_aplConfiguration = std::make_shared<AplConfiguration>(aplOptions);
+    m_aplCoreConnectionManager = std::make_shared<AplCoreConnectionManager>(m_aplConfiguration);
+
+    EXPECT_CALL(*aplOptions, sendMessage(_, MatchOutMessage("\"type\":\"hierarchy\"", ""))).Times(0);
+    BuildDocument(DOCUMENT_MANY_FRAMES, DATA, VIEWPORT);
+
+    auto hierarchy = std::find_if(aplOptions->transferred.begin(), aplOptions->transferred.end(),
+        [](const std::string& message) { return message.find("\"type\":\"hierarchy\"") != std::string::npos; });
+    ASSERT_NE(aplOptions->transferred.end(), hierarchy);
+    rapidjson::Document parsed;
+    ASSERT_FALSE(parsed.Parse(hierarchy->c_str()).HasParseError());
+}
+
 TEST_F(AplCoreConnectionManagerTest, ProvideStateSuccess) {
     SetupMocksForDocumentRender();
     BuildDocument(DOCUMENT, DATA, VIEWPORT);
@@ -1116,6 +1963,23 @@ TEST_F(AplCoreConnectionManagerTest, LoadPackage) {
     m_aplCoreConnectionManager->loadPackage(content);
 }
 
+TEST_F(AplCoreConnectionManagerTest, LoadPackageUsesPackageCache) {
+    const std::string packageContent = "{\"type\": \"APL\", \"version\": \"1.0.0\"}";
+
+    EXPECT_CALL(*m_mockAplOptions, downloadResource(SOURCE)).Times(1).WillOnce(Return(packageContent));
+    EXPECT_CALL(*m_mockAplOptions, getMaxNumberOfConcurrentDownloads()).WillRepeatedly(Return(5));
+
+    auto content = apl::Content::create(DOCUMENT_APL_WITH_PACKAGE);
+    ASSERT_TRUE(m_aplCoreConnectionManager->loadPackage(content));
+    ASSERT_EQ(1u, m_aplConfiguration->getPackageCache()->size());
+
+    // Renderers sharing the configuration resolve the import from the cache
+    auto otherConnectionManager = std::make_shared<AplCoreConnectionManager>(m_aplConfiguration);
+    auto cachedContent = apl::Content::create(DOCUMENT_APL_WITH_PACKAGE);
+    ASSERT_TRUE(otherConnectionManager->loadPackage(cachedContent));
+    ASSERT_FALSE(cachedContent->isWaiting());
+}
+
 // 
 // Extensions
 // 
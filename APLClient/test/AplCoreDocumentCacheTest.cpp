@@ -0,0 +1,113 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "APLClient/AplCoreDocumentCache.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace ::testing;
+
+namespace APLClient {
+namespace test {
+
+static Extensions::AplDocumentStatePtr makeState(const std::string& token) {
+    return std::make_shared<Extensions::AplDocumentState>(token, nullptr, nullptr);
+}
+
+static const std::string ENVIRONMENT = "[1920,1080]";
+
+TEST(AplCoreDocumentCacheTest, KeyIncludesEveryPart) {
+    auto documentKey = AplCoreDocumentCache::makeDocumentKey("document", "data", "viewports");
+    ASSERT_EQ(documentKey, AplCoreDocumentCache::makeDocumentKey("document", "data", "viewports"));
+    ASSERT_NE(documentKey, AplCoreDocumentCache::makeDocumentKey("document", "other", "viewports"));
+    ASSERT_NE(documentKey, AplCoreDocumentCache::makeDocumentKey("document", "data", "other"));
+    ASSERT_NE(
+        AplCoreDocumentCache::makeDocumentKey("ab", "c", ""), AplCoreDocumentCache::makeDocumentKey("a", "bc", ""));
+}
+
+TEST(AplCoreDocumentCacheTest, UncachedKeyHoldsSameHash) {
+    auto documentKey = AplCoreDocumentCache::makeDocumentKey("document", "data", "viewports");
+    auto uncachedKey = AplCoreDocumentCache::makeUncachedDocumentKey("document", "data", "viewports");
+    ASSERT_FALSE(documentKey.empty());
+    ASSERT_TRUE(uncachedKey.empty());
+    ASSERT_EQ(documentKey.hash, uncachedKey.hash);
+
+    AplCoreDocumentCache cache(2);
+    cache.put(uncachedKey, ENVIRONMENT, makeState("first"));
+    ASSERT_EQ(0u, cache.size());
+}
+
+TEST(AplCoreDocumentCacheTest, DisabledByDefault) {
+    AplCoreDocumentCache cache;
+    ASSERT_FALSE(cache.isEnabled());
+
+    auto first = AplCoreDocumentCache::makeDocumentKey("first", "", "");
+    cache.put(first, ENVIRONMENT, makeState("first"));
+    ASSERT_EQ(0u, cache.size());
+    ASSERT_EQ(nullptr, cache.get(first, ENVIRONMENT));
+}
+
+TEST(AplCoreDocumentCacheTest, EvictsLeastRecentlyUsed) {
+    auto first = AplCoreDocumentCache::makeDocumentKey("first", "", "");
+    auto second = AplCoreDocumentCache::makeDocumentKey("second", "", "");
+    auto third = AplCoreDocumentCache::makeDocumentKey("third", "", "");
+
+    AplCoreDocumentCache cache(2);
+    cache.put(first, ENVIRONMENT, makeState("first"));
+    cache.put(second, ENVIRONMENT, makeState("second"));
+    ASSERT_NE(nullptr, cache.get(first, ENVIRONMENT));
+    cache.put(third, ENVIRONMENT, makeState("third"));
+
+    ASSERT_EQ(2u, cache.size());
+    ASSERT_EQ(nullptr, cache.get(second, ENVIRONMENT));
+    ASSERT_EQ("first", cache.get(first, ENVIRONMENT)->token);
+
+    cache.erase(first, ENVIRONMENT);
+    ASSERT_EQ(nullptr, cache.get(first, ENVIRONMENT));
+
+    cache.setMaxEntries(0);
+    ASSERT_EQ(0u, cache.size());
+}
+
+TEST(AplCoreDocumentCacheTest, MissesOtherEnvironment) {
+    auto documentKey = AplCoreDocumentCache::makeDocumentKey("document", "data", "viewports");
+
+    AplCoreDocumentCache cache(2);
+    cache.put(documentKey, ENVIRONMENT, makeState("first"));
+    ASSERT_EQ(nullptr, cache.get(documentKey, "[1280,800]"));
+    ASSERT_NE(nullptr, cache.get(AplCoreDocumentCache::makeDocumentKey("document", "data", "viewports"), ENVIRONMENT));
+}
+
+TEST(AplCoreDocumentCacheTest, MissesCollidingInputs) {
+    auto documentKey = AplCoreDocumentCache::makeDocumentKey("document", "data", "viewports");
+    auto colliding = AplCoreDocumentCache::makeDocumentKey("other", "data", "viewports");
+    colliding.hash = documentKey.hash;
+
+    AplCoreDocumentCache cache(2);
+    cache.put(documentKey, ENVIRONMENT, makeState("first"));
+    ASSERT_EQ(nullptr, cache.get(colliding, ENVIRONMENT));
+
+    cache.erase(colliding, ENVIRONMENT);
+    ASSERT_EQ("first", cache.get(documentKey, ENVIRONMENT)->token);
+
+    cache.put(colliding, ENVIRONMENT, makeState("second"));
+    ASSERT_EQ(1u, cache.size());
+    ASSERT_EQ(nullptr, cache.get(documentKey, ENVIRONMENT));
+    ASSERT_EQ("second", cache.get(colliding, ENVIRONMENT)->token);
+}
+
+}  // namespace test
+}  // namespace APLClient
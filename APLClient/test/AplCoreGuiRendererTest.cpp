@@ -13,6 +13,11 @@
  * permissions and limitations under the License.
  */
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
 #include "APLClient/AplCoreGuiRenderer.h"
 #include "APLClient/Telemetry/NullAplMetricsRecorder.h"
 #include "MockAplCoreConnectionManager.h"
@@ -57,6 +62,20 @@ static const std::string DOCUMENT_APL_WITH_PACKAGE = "{"
                          "   }"
                          "}";
 
+static const std::string DOCUMENT_APL_WITHOUT_PACKAGE = "{"
+                         "  \"type\": \"APL\","
+                         "  \"version\": \"1.0\","
+                         "  \"mainTemplate\": {"
+                         "    \"parameters\": ["
+                         "      \"payload\""
+                         "    ],"
+                         "    \"item\": {"
+                         "      \"type\": \"Text\","
+                         "      \"text\": \"Hello World\""
+                         "    }"
+                         "  }"
+                         "}";
+
 const std::string SOURCE =
             "https://arl.assets.apl-alexa.com/packages/alexa-viewport-profiles/1.0.0/document.json";
 
@@ -161,5 +180,67 @@ TEST_F(AplCoreGuiRendererTest, RenderEmptyPackageContent){
 }
 
 
+/**
+ * Tests that a prefetched document is rendered without loading its packages again.
+ */
+TEST_F(AplCoreGuiRendererTest, RenderPrefetchedDocument){
+    EXPECT_CALL(*m_mockAplCoreConnectionManager, loadPackage(_)).Times(1).WillOnce(Return(true));
+    EXPECT_CALL(*m_mockAplCoreConnectionManager, setSupportedViewports(VIEWPORT_PAYLOAD)).Times(1);
+    EXPECT_CALL(*m_mockAplCoreConnectionManager, setContent(_, _)).Times(1);
+
+    m_aplCoreGuiRenderer->prefetchDocument(DOCUMENT_APL_WITHOUT_PACKAGE, DATA);
+    m_aplCoreGuiRenderer->renderDocument(DOCUMENT_APL_WITHOUT_PACKAGE, DATA, VIEWPORT_PAYLOAD, TOKEN);
+}
+
+/**
+ * Tests that a prefetch for a different document is not used.
+ */
+TEST_F(AplCoreGuiRendererTest, IgnorePrefetchOfOtherDocument){
+    std::atomic<int> loads{0};
+    EXPECT_CALL(*m_mockAplCoreConnectionManager, loadPackage(_))
+        .Times(2)
+        .WillRepeatedly(Invoke([&loads](const apl::ContentPtr&) {
+            loads++;
+            return false;
+        }));
+
+    m_aplCoreGuiRenderer->prefetchDocument(DOCUMENT_APL_WITH_PACKAGE, "{\"other\": {}}");
+    m_aplCoreGuiRenderer->renderDocument(DOCUMENT_APL_WITH_PACKAGE, DATA, VIEWPORT_PAYLOAD, TOKEN);
+
+    // The prefetch loads its packages on the prefetch thread
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (loads < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(2, loads);
+}
+
+/**
+ * Tests that a prefetch superseded before it starts is skipped, and the most recent one is rendered.
+ */
+TEST_F(AplCoreGuiRendererTest, SkipsSupersededPrefetch){
+    std::promise<void> firstStarted;
+    std::promise<void> releaseFirst;
+    auto firstReleased = releaseFirst.get_future().share();
+    EXPECT_CALL(*m_mockAplCoreConnectionManager, loadPackage(_))
+        .Times(2)
+        .WillOnce(Invoke([&firstStarted, firstReleased](const apl::ContentPtr&) {
+            firstStarted.set_value();
+            firstReleased.wait();
+            return true;
+        }))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*m_mockAplCoreConnectionManager, setSupportedViewports(VIEWPORT_PAYLOAD)).Times(1);
+    EXPECT_CALL(*m_mockAplCoreConnectionManager, setContent(_, _)).Times(1);
+
+    m_aplCoreGuiRenderer->prefetchDocument(DOCUMENT_APL_WITHOUT_PACKAGE, "{\"first\": {}}");
+    firstStarted.get_future().wait();
+    m_aplCoreGuiRenderer->prefetchDocument(DOCUMENT_APL_WITHOUT_PACKAGE, "{\"second\": {}}");
+    m_aplCoreGuiRenderer->prefetchDocument(DOCUMENT_APL_WITHOUT_PACKAGE, DATA);
+    releaseFirst.set_value();
+
+    m_aplCoreGuiRenderer->renderDocument(DOCUMENT_APL_WITHOUT_PACKAGE, DATA, VIEWPORT_PAYLOAD, TOKEN);
+}
+
 } // namespace test
 } // namespace APLClient
@@ -0,0 +1,135 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "APLClient/AplCoreHierarchyDiff.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace ::testing;
+
+namespace APLClient {
+namespace test {
+
+static const char HIERARCHY[] =
+    "{\"id\": \"1\", \"type\": 2, \"width\": 100, \"children\": ["
+    "  {\"id\": \"2\", \"type\": 5, \"text\": \"first\"},"
+    "  {\"id\": \"3\", \"type\": 5, \"text\": \"second\"},"
+    "  {\"id\": \"4\", \"type\": 1, \"source\": \"image.png\"}"
+    "]}";
+
+TEST(AplCoreHierarchyDiffTest, FailsWithoutRecordedHierarchy) {
+    AplCoreHierarchyDiff hierarchyDiff;
+    rapidjson::Document hierarchy;
+    hierarchy.Parse(HIERARCHY);
+    rapidjson::Value diff;
+    ASSERT_TRUE(hierarchyDiff.empty());
+    ASSERT_FALSE(hierarchyDiff.diff(hierarchy, hierarchy.GetAllocator(), diff));
+}
+
+TEST(AplCoreHierarchyDiffTest, UnchangedHierarchyHasEmptyDiff) {
+    AplCoreHierarchyDiff hierarchyDiff;
+    rapidjson::Document hierarchy;
+    hierarchy.Parse(HIERARCHY);
+    hierarchyDiff.record(hierarchy);
+
+    rapidjson::Document next;
+    next.Parse(HIERARCHY);
+    rapidjson::Value diff;
+    ASSERT_TRUE(hierarchyDiff.diff(next, next.GetAllocator(), diff));
+    ASSERT_EQ(0u, diff["removed"].Size());
+    ASSERT_EQ(0u, diff["updated"].Size());
+    ASSERT_EQ(0u, diff["added"].Size());
+    ASSERT_EQ(0u, diff["children"].MemberCount());
+}
+
+TEST(AplCoreHierarchyDiffTest, DiffsReinflatedHierarchy) {
+    AplCoreHierarchyDiff hierarchyDiff;
+    rapidjson::Document hierarchy;
+    hierarchy.Parse(HIERARCHY);
+    hierarchyDiff.record(hierarchy);
+
+    // New uids, the root resized, the texts swapped places, the image replaced by a frame
+    rapidjson::Document next;
+    next.Parse(
+        "{\"id\": \"11\", \"type\": 2, \"width\": 200, \"children\": ["
+        "  {\"id\": \"13\", \"type\": 5, \"text\": \"second\"},"
+        "  {\"id\": \"12\", \"type\": 5, \"text\": \"first\"},"
+        "  {\"id\": \"14\", \"type\": 3}"
+        "]}");
+    rapidjson::Value diff;
+    ASSERT_TRUE(hierarchyDiff.diff(next, next.GetAllocator(), diff));
+
+    ASSERT_EQ(1u, diff["removed"].Size());
+    ASSERT_STREQ("4", diff["removed"][0].GetString());
+
+    auto& updated = diff["updated"];
+    ASSERT_EQ(3u, updated.Size());
+    ASSERT_STREQ("1", updated[0]["uid"].GetString());
+    ASSERT_STREQ("11", updated[0]["newUid"].GetString());
+    ASSERT_EQ(1u, updated[0]["properties"].MemberCount());
+    ASSERT_EQ(200, updated[0]["properties"]["width"].GetInt());
+    ASSERT_STREQ("3", updated[1]["uid"].GetString());
+    ASSERT_STREQ("13", updated[1]["newUid"].GetString());
+    ASSERT_FALSE(updated[1].HasMember("properties"));
+
+    ASSERT_EQ(1u, diff["added"].Size());
+    ASSERT_STREQ("11", diff["added"][0]["parent"].GetString());
+    ASSERT_STREQ("14", diff["added"][0]["component"]["id"].GetString());
+
+    auto& order = diff["children"]["11"];
+    ASSERT_EQ(3u, order.Size());
+    ASSERT_STREQ("13", order[0].GetString());
+    ASSERT_STREQ("12", order[1].GetString());
+    ASSERT_STREQ("14", order[2].GetString());
+}
+
+TEST(AplCoreHierarchyDiffTest, InvalidatedComponentSendsAllProperties) {
+    AplCoreHierarchyDiff hierarchyDiff;
+    rapidjson::Document hierarchy;
+    hierarchy.Parse(HIERARCHY);
+    hierarchyDiff.record(hierarchy);
+    hierarchyDiff.invalidate("2");
+
+    rapidjson::Document next;
+    next.Parse(HIERARCHY);
+    rapidjson::Value diff;
+    ASSERT_TRUE(hierarchyDiff.diff(next, next.GetAllocator(), diff));
+    ASSERT_EQ(1u, diff["updated"].Size());
+    ASSERT_STREQ("2", diff["updated"][0]["uid"].GetString());
+    ASSERT_STREQ("first", diff["updated"][0]["properties"]["text"].GetString());
+
+    // The diff records the new hierarchy
+    rapidjson::Document again;
+    again.Parse(HIERARCHY);
+    ASSERT_TRUE(hierarchyDiff.diff(again, again.GetAllocator(), diff));
+    ASSERT_EQ(0u, diff["updated"].Size());
+}
+
+TEST(AplCoreHierarchyDiffTest, FailsWhenTopComponentChangesType) {
+    AplCoreHierarchyDiff hierarchyDiff;
+    rapidjson::Document hierarchy;
+    hierarchy.Parse(HIERARCHY);
+    hierarchyDiff.record(hierarchy);
+
+    rapidjson::Document next;
+    next.Parse("{\"id\": \"1\", \"type\": 3}");
+    rapidjson::Value diff;
+    ASSERT_FALSE(hierarchyDiff.diff(next, next.GetAllocator(), diff));
+    ASSERT_FALSE(hierarchyDiff.empty());
+}
+
+}  // namespace test
+}  // namespace APLClient
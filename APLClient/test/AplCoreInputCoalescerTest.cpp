@@ -0,0 +1,77 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <vector>
+
+#include "APLClient/AplCoreInputCoalescer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace ::testing;
+
+namespace APLClient {
+namespace test {
+
+static void push(AplCoreInputCoalescer& coalescer, const std::string& type, const std::string& key, int value) {
+    rapidjson::Document payload;
+    payload.SetObject();
+    payload.AddMember("value", value, payload.GetAllocator());
+    coalescer.push(type, key, payload);
+}
+
+static std::vector<std::pair<std::string, int>> flush(AplCoreInputCoalescer& coalescer) {
+    std::vector<std::pair<std::string, int>> applied;
+    coalescer.flush([&applied](const std::string& type, const rapidjson::Value& payload) {
+        applied.emplace_back(type, payload["value"].GetInt());
+    });
+    return applied;
+}
+
+TEST(AplCoreInputCoalescerTest, KeepsLatestMessagePerKey) {
+    AplCoreInputCoalescer coalescer;
+    push(coalescer, "handlePointerEvent", "pointerMove#0", 1);
+    push(coalescer, "update", "scrollPosition#list", 10);
+    push(coalescer, "handlePointerEvent", "pointerMove#1", 100);
+    push(coalescer, "handlePointerEvent", "pointerMove#0", 2);
+    push(coalescer, "update", "scrollPosition#list", 20);
+    ASSERT_EQ(3u, coalescer.size());
+
+    auto applied = flush(coalescer);
+    ASSERT_EQ(3u, applied.size());
+    // A superseding message takes the place of the latest one
+    ASSERT_EQ(std::make_pair(std::string("handlePointerEvent"), 100), applied[0]);
+    ASSERT_EQ(std::make_pair(std::string("handlePointerEvent"), 2), applied[1]);
+    ASSERT_EQ(std::make_pair(std::string("update"), 20), applied[2]);
+    ASSERT_TRUE(coalescer.empty());
+}
+
+TEST(AplCoreInputCoalescerTest, FlushStartsNewFrame) {
+    AplCoreInputCoalescer coalescer;
+    push(coalescer, "mediaPlayerUpdateMediaState", "mediaPlayerState#player", 1);
+    ASSERT_EQ(1u, flush(coalescer).size());
+
+    push(coalescer, "mediaPlayerUpdateMediaState", "mediaPlayerState#player", 2);
+    auto applied = flush(coalescer);
+    ASSERT_EQ(1u, applied.size());
+    ASSERT_EQ(2, applied[0].second);
+
+    push(coalescer, "mediaPlayerUpdateMediaState", "mediaPlayerState#player", 3);
+    coalescer.clear();
+    ASSERT_TRUE(flush(coalescer).empty());
+}
+
+}  // namespace test
+}  // namespace APLClient
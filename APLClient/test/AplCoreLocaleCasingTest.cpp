@@ -0,0 +1,57 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "APLClient/AplCoreLocaleCasing.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace ::testing;
+
+namespace APLClient {
+namespace test {
+
+TEST(AplCoreLocaleCasingTest, CasesCoveredScripts) {
+    std::string result;
+
+    ASSERT_TRUE(AplCoreLocaleCasing::toUpperCase("Hello, world 42", "en-US", result));
+    ASSERT_EQ("HELLO, WORLD 42", result);
+    ASSERT_TRUE(AplCoreLocaleCasing::toLowerCase("\xC3\x89T\xC3\x89", "fr-FR", result));
+    ASSERT_EQ("\xC3\xA9t\xC3\xA9", result);
+    ASSERT_TRUE(AplCoreLocaleCasing::toUpperCase("stra\xC3\x9F" "e", "de-DE", result));
+    ASSERT_EQ("STRASSE", result);
+    ASSERT_TRUE(AplCoreLocaleCasing::toUpperCase("\xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82", "ru", result));
+    ASSERT_EQ("\xD0\x9F\xD0\xA0\xD0\x98\xD0\x92\xD0\x95\xD0\xA2", result);
+    ASSERT_TRUE(AplCoreLocaleCasing::toLowerCase("\xE6\x97\xA5\xE6\x9C\xAC", "ja-JP", result));
+    ASSERT_EQ("\xE6\x97\xA5\xE6\x9C\xAC", result);
+}
+
+TEST(AplCoreLocaleCasingTest, DefersLocaleSensitiveCasing) {
+    std::string result = "unchanged";
+
+    ASSERT_FALSE(AplCoreLocaleCasing::toUpperCase("istanbul", "tr-TR", result));
+    ASSERT_FALSE(AplCoreLocaleCasing::toLowerCase("I", "az", result));
+    ASSERT_TRUE(AplCoreLocaleCasing::toUpperCase("ankara", "tr-TR", result));
+    ASSERT_EQ("ANKARA", result);
+
+    // Lower case sigma depends on its position in the word
+    ASSERT_FALSE(AplCoreLocaleCasing::toLowerCase("\xCE\xA3", "el-GR", result));
+    // Invalid UTF-8
+    ASSERT_FALSE(AplCoreLocaleCasing::toUpperCase("\xC3", "en-US", result));
+    ASSERT_EQ("ANKARA", result);
+}
+
+}  // namespace test
+}  // namespace APLClient
@@ -0,0 +1,140 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "APLClient/AplCorePackageCache.h"
+
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace ::testing;
+
+namespace APLClient {
+namespace test {
+
+static void put(AplCorePackageCache& cache, const AplCorePackageCache::Key& key, const std::string& raw) {
+    rapidjson::Document package;
+    package.Parse(raw.c_str());
+    cache.put(key, raw, package);
+}
+
+/**
+ * @return A directory for package files, created in the test temporary directory
+ */
+static std::string makeDirectory(const std::string& name) {
+    auto directory = TempDir();
+    if (!directory.empty() && directory.back() != '/') {
+        directory += '/';
+    }
+    directory += name + "/";
+    mkdir(directory.c_str(), 0755);
+    return directory;
+}
+
+/**
+ * @return The path of the only package file in a directory, or an empty string if there is not exactly one
+ */
+static std::string findPackageFile(const std::string& directory) {
+    std::string found;
+    int count = 0;
+    if (auto dir = opendir(directory.c_str())) {
+        while (auto entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0) {
+                found = directory + name;
+                count++;
+            }
+        }
+        closedir(dir);
+    }
+    return count == 1 ? found : "";
+}
+
+TEST(AplCorePackageCacheTest, KeyIncludesVersionAndSource) {
+    auto key = AplCorePackageCache::makeKey("alexa-layouts", "1.4.0", "");
+    ASSERT_EQ(key, AplCorePackageCache::makeKey("alexa-layouts", "1.4.0", ""));
+    ASSERT_NE(key, AplCorePackageCache::makeKey("alexa-layouts", "1.5.0", ""));
+    ASSERT_NE(key, AplCorePackageCache::makeKey("alexa-layouts", "1.4.0", "https://example.com/layouts.json"));
+    ASSERT_NE(AplCorePackageCache::makeKey("a", "bc", ""), AplCorePackageCache::makeKey("ab", "c", ""));
+}
+
+TEST(AplCorePackageCacheTest, EvictsLeastRecentlyUsed) {
+    AplCorePackageCache cache(2);
+    rapidjson::Document package;
+
+    put(cache, "first", "{\"version\": \"1\"}");
+    put(cache, "second", "{\"version\": \"2\"}");
+    ASSERT_TRUE(cache.get("first", package));
+    put(cache, "third", "{\"version\": \"3\"}");
+
+    ASSERT_EQ(2u, cache.size());
+    ASSERT_FALSE(cache.get("second", package));
+    ASSERT_TRUE(cache.get("first", package));
+    ASSERT_STREQ("1", package["version"].GetString());
+
+    cache.clear();
+    ASSERT_EQ(0u, cache.size());
+    ASSERT_FALSE(cache.get("first", package));
+}
+
+TEST(AplCorePackageCacheTest, DiskTierSurvivesNewCache) {
+    auto key = AplCorePackageCache::makeKey("disk-tier-test", "1.0.0", "");
+
+    AplCorePackageCache cache;
+    cache.setDirectory(TempDir());
+    put(cache, key, "{\"type\": \"APL\", \"version\": \"1.0.0\"}");
+
+    AplCorePackageCache restarted;
+    rapidjson::Document package;
+    ASSERT_FALSE(restarted.get(key, package));
+
+    restarted.setDirectory(TempDir());
+    ASSERT_TRUE(restarted.get(key, package));
+    ASSERT_STREQ("APL", package["type"].GetString());
+    ASSERT_EQ(1u, restarted.size());
+}
+
+TEST(AplCorePackageCacheTest, DiskTierChecksKey) {
+    auto first = AplCorePackageCache::makeKey("first-package", "1.0.0", "");
+    auto second = AplCorePackageCache::makeKey("second-package", "1.0.0", "");
+    auto firstDirectory = makeDirectory("package-cache-first");
+    auto secondDirectory = makeDirectory("package-cache-second");
+
+    AplCorePackageCache cache;
+    cache.setDirectory(firstDirectory);
+    put(cache, first, "{\"name\": \"first\"}");
+    cache.setDirectory(secondDirectory);
+    put(cache, second, "{\"name\": \"second\"}");
+    auto firstFile = findPackageFile(firstDirectory);
+    auto secondFile = findPackageFile(secondDirectory);
+    ASSERT_FALSE(firstFile.empty());
+    ASSERT_FALSE(secondFile.empty());
+
+    // Make the file of the second package hold the first, as if both keys hashed to the same name
+    std::remove(secondFile.c_str());
+    ASSERT_EQ(0, std::rename(firstFile.c_str(), secondFile.c_str()));
+
+    AplCorePackageCache restarted;
+    restarted.setDirectory(secondDirectory);
+    rapidjson::Document package;
+    ASSERT_FALSE(restarted.get(second, package));
+    ASSERT_EQ(0u, restarted.size());
+}
+
+}  // namespace test
+}  // namespace APLClient
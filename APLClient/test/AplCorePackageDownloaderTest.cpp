@@ -0,0 +1,131 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <chrono>
+#include <future>
+
+#include "APLClient/AplCorePackageDownloader.h"
+#include "MockAplOptionsInterface.h"
+
+using namespace ::testing;
+
+namespace APLClient {
+namespace test {
+
+static const std::string SLOW_SOURCE = "https://example.com/slow/document.json";
+static const std::string FAST_SOURCE = "https://example.com/fast/document.json";
+
+TEST(AplCorePackageDownloaderTest, ReturnsDownloadsInCompletionOrder) {
+    auto mockAplOptions = std::make_shared<NiceMock<MockAplOptionsInterface>>();
+    std::promise<void> releaseSlow;
+    auto slowReleased = releaseSlow.get_future().share();
+
+    EXPECT_CALL(*mockAplOptions, downloadResource(SLOW_SOURCE)).WillOnce(Invoke([slowReleased](const std::string&) {
+        slowReleased.wait();
+        return std::string("slow");
+    }));
+    EXPECT_CALL(*mockAplOptions, downloadResource(FAST_SOURCE)).WillOnce(Return("fast"));
+
+    AplCorePackageDownloader downloader(mockAplOptions, 2);
+    auto batch = downloader.createBatch();
+    batch->request(1, SLOW_SOURCE);
+    batch->request(2, FAST_SOURCE);
+
+    uint32_t requestId;
+    std::string content;
+    ASSERT_TRUE(batch->next(requestId, content));
+    ASSERT_EQ(2u, requestId);
+    ASSERT_EQ("fast", content);
+
+    releaseSlow.set_value();
+    ASSERT_TRUE(batch->next(requestId, content));
+    ASSERT_EQ(1u, requestId);
+    ASSERT_EQ("slow", content);
+
+    ASSERT_FALSE(batch->next(requestId, content));
+}
+
+TEST(AplCorePackageDownloaderTest, QueuesRequestsBeyondTheLimit) {
+    auto mockAplOptions = std::make_shared<NiceMock<MockAplOptionsInterface>>();
+    EXPECT_CALL(*mockAplOptions, downloadResource(_)).Times(3).WillRepeatedly(Return("package"));
+
+    AplCorePackageDownloader downloader(mockAplOptions, 1);
+    auto batch = downloader.createBatch();
+    for (uint32_t id = 1; id <= 3; id++) {
+        batch->request(id, FAST_SOURCE);
+    }
+
+    uint32_t requestId;
+    std::string content;
+    for (uint32_t id = 1; id <= 3; id++) {
+        ASSERT_TRUE(batch->next(requestId, content));
+        // A single worker runs the queue in order
+        ASSERT_EQ(id, requestId);
+    }
+    ASSERT_FALSE(batch->next(requestId, content));
+}
+
+TEST(AplCorePackageDownloaderTest, ReturnsDownloadsToTheirOwnBatch) {
+    auto mockAplOptions = std::make_shared<NiceMock<MockAplOptionsInterface>>();
+    EXPECT_CALL(*mockAplOptions, downloadResource(SLOW_SOURCE)).WillOnce(Return("slow"));
+    EXPECT_CALL(*mockAplOptions, downloadResource(FAST_SOURCE)).WillOnce(Return("fast"));
+
+    AplCorePackageDownloader downloader(mockAplOptions, 2);
+    auto first = downloader.createBatch();
+    auto second = downloader.createBatch();
+    first->request(1, SLOW_SOURCE);
+    second->request(1, FAST_SOURCE);
+
+    uint32_t requestId;
+    std::string content;
+    ASSERT_TRUE(second->next(requestId, content));
+    ASSERT_EQ("fast", content);
+    ASSERT_FALSE(second->next(requestId, content));
+
+    ASSERT_TRUE(first->next(requestId, content));
+    ASSERT_EQ("slow", content);
+    ASSERT_FALSE(first->next(requestId, content));
+}
+
+TEST(AplCorePackageDownloaderTest, AbandonsBatchWithoutWaiting) {
+    auto mockAplOptions = std::make_shared<NiceMock<MockAplOptionsInterface>>();
+    std::promise<void> releaseSlow;
+    auto slowReleased = releaseSlow.get_future().share();
+    std::promise<void> slowStarted;
+
+    EXPECT_CALL(*mockAplOptions, downloadResource(SLOW_SOURCE))
+        .WillOnce(Invoke([slowReleased, &slowStarted](const std::string&) {
+            slowStarted.set_value();
+            slowReleased.wait();
+            return std::string("slow");
+        }));
+    // The request queued behind the slow download on the only worker is dropped with its batch
+    EXPECT_CALL(*mockAplOptions, downloadResource(FAST_SOURCE)).Times(0);
+
+    AplCorePackageDownloader downloader(mockAplOptions, 1);
+    auto batch = downloader.createBatch();
+    batch->request(1, SLOW_SOURCE);
+    batch->request(2, FAST_SOURCE);
+    slowStarted.get_future().wait();
+
+    auto start = std::chrono::steady_clock::now();
+    batch.reset();
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    releaseSlow.set_value();
+}
+
+}  // namespace test
+}  // namespace APLClient
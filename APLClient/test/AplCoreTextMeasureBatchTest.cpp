@@ -0,0 +1,163 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "APLClient/AplCoreTextMeasureBatch.h"
+#include "MockAplOptionsInterface.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+namespace APLClient {
+namespace test {
+
+using namespace ::testing;
+
+/// Two texts with the same properties and constraints, and one which differs
+static const std::string DOCUMENT =
+    "{"
+    "  \"type\": \"APL\","
+    "  \"version\": \"1.4\","
+    "  \"mainTemplate\": {"
+    "    \"items\": {"
+    "      \"type\": \"Container\","
+    "      \"width\": \"100%\","
+    "      \"height\": \"100%\","
+    "      \"items\": ["
+    "        { \"type\": \"Text\", \"width\": 400, \"text\": \"Hello\" },"
+    "        { \"type\": \"Text\", \"width\": 400, \"text\": \"Hello\" },"
+    "        { \"type\": \"Text\", \"width\": 400, \"text\": \"World\" }"
+    "      ]"
+    "    }"
+    "  }"
+    "}";
+
+/// Test harness for @c AplCoreTextMeasureBatch class.
+class AplCoreTextMeasureBatchTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        m_mockAplOptions = std::make_shared<NiceMock<MockAplOptionsInterface>>();
+        m_aplConfiguration = std::make_shared<AplConfiguration>(m_mockAplOptions);
+        m_aplCoreConnectionManager = std::make_shared<AplCoreConnectionManager>(m_aplConfiguration);
+        m_metrics.size(1024, 600).dpi(160);
+        m_aplCoreMetrics = std::make_shared<AplCoreMetrics>(m_metrics);
+    }
+
+    /**
+     * Lays @c DOCUMENT out with the batch as its text measurement
+     */
+    void dryRun(const std::shared_ptr<AplCoreTextMeasureBatch>& batch) {
+        auto content = apl::Content::create(DOCUMENT);
+        ASSERT_TRUE(content && content->isReady());
+        auto root = apl::RootContext::create(m_metrics, content, apl::RootConfig().measure(batch));
+        ASSERT_TRUE(root);
+    }
+
+protected:
+    std::shared_ptr<MockAplOptionsInterface> m_mockAplOptions;
+    AplConfigurationPtr m_aplConfiguration;
+    std::shared_ptr<AplCoreConnectionManager> m_aplCoreConnectionManager;
+    apl::Metrics m_metrics;
+    AplCoreMetricsPtr m_aplCoreMetrics;
+};
+
+/**
+ * Answers a measureBatch request as the viewhost would, with the same size for every entry
+ */
+static std::string makeReply(const std::string& request) {
+    rapidjson::Document parsed;
+    parsed.Parse(request.c_str());
+
+    rapidjson::Document reply(rapidjson::kObjectType);
+    auto& alloc = reply.GetAllocator();
+    rapidjson::Value results(rapidjson::kArrayType);
+    for (rapidjson::SizeType i = 0; i < parsed["payload"].Size(); i++) {
+        rapidjson::Value result(rapidjson::kObjectType);
+        result.AddMember("width", 400, alloc);
+        result.AddMember("height", 40, alloc);
+        results.PushBack(result, alloc);
+    }
+    reply.AddMember("type", "measureBatch", alloc);
+    reply.AddMember("seqno", parsed["seqno"].GetInt(), alloc);
+    reply.AddMember("payload", results, alloc);
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    reply.Accept(writer);
+    return buffer.GetString();
+}
+
+/**
+ * Test that measurements of texts with the same properties and constraints are recorded once, and that nothing is
+ * sent to the viewhost while recording.
+ */
+TEST_F(AplCoreTextMeasureBatchTest, RecordsDistinctMeasurements) {
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _)).Times(0);
+    auto batch = std::make_shared<AplCoreTextMeasureBatch>(m_aplCoreMetrics, m_aplConfiguration);
+
+    dryRun(batch);
+
+    ASSERT_EQ(2u, batch->size());
+}
+
+/**
+ * Test that the recorded measurements are sent as one message and that the reply primes the cache, so that the same
+ * document laid out again records nothing.
+ */
+TEST_F(AplCoreTextMeasureBatchTest, ReplyPrimesCache) {
+    auto batch = std::make_shared<AplCoreTextMeasureBatch>(m_aplCoreMetrics, m_aplConfiguration);
+    dryRun(batch);
+
+    std::string request;
+    auto* aplCoreConnectionManager = m_aplCoreConnectionManager.get();
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _))
+        .Times(1)
+        .WillOnce(Invoke([aplCoreConnectionManager, &request](const std::string&, const std::string& payload) {
+            request = payload;
+            aplCoreConnectionManager->shouldHandleMessage(makeReply(payload));
+        }));
+    ASSERT_EQ(2u, batch->send(*m_aplCoreConnectionManager));
+    ASSERT_NE(std::string::npos, request.find("\"type\":\"measureBatch\""));
+    ASSERT_EQ(2u, m_aplConfiguration->getTextMeasureCache()->size());
+
+    auto primed = std::make_shared<AplCoreTextMeasureBatch>(m_aplCoreMetrics, m_aplConfiguration);
+    dryRun(primed);
+    ASSERT_EQ(0u, primed->size());
+    ASSERT_EQ(0u, primed->send(*m_aplCoreConnectionManager));
+}
+
+/**
+ * Test that an invalid reply leaves the cache untouched.
+ */
+TEST_F(AplCoreTextMeasureBatchTest, InvalidReplyAddsNothing) {
+    auto batch = std::make_shared<AplCoreTextMeasureBatch>(m_aplCoreMetrics, m_aplConfiguration);
+    dryRun(batch);
+
+    auto* aplCoreConnectionManager = m_aplCoreConnectionManager.get();
+    EXPECT_CALL(*m_mockAplOptions, sendMessage(_, _))
+        .WillOnce(Invoke([aplCoreConnectionManager](const std::string&, const std::string& payload) {
+            rapidjson::Document parsed;
+            parsed.Parse(payload.c_str());
+            aplCoreConnectionManager->shouldHandleMessage(
+                "{\"type\":\"measureBatch\",\"seqno\":" + std::to_string(parsed["seqno"].GetInt()) +
+                ",\"payload\":{}}");
+        }));
+    ASSERT_EQ(0u, batch->send(*m_aplCoreConnectionManager));
+    ASSERT_EQ(0u, m_aplConfiguration->getTextMeasureCache()->size());
+}
+
+}  // namespace test
+}  // namespace APLClient
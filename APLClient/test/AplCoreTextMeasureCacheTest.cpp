@@ -0,0 +1,83 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "APLClient/AplCoreTextMeasureCache.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace ::testing;
+
+namespace APLClient {
+namespace test {
+
+static rapidjson::Document parse(const std::string& json) {
+    rapidjson::Document doc;
+    doc.Parse(json.c_str());
+    return doc;
+}
+
+TEST(AplCoreTextMeasureCacheTest, KeyIgnoresIdentityAndLayoutOutput) {
+    auto first = parse("{\"id\": \"1000\", \"text\": \"Hello\", \"fontSize\": 40, \"_bounds\": [0, 0, 10, 10]}");
+    auto second = parse("{\"id\": \"1001\", \"text\": \"Hello\", \"fontSize\": 40, \"_bounds\": [0, 20, 10, 10]}");
+    auto other = parse("{\"id\": \"1002\", \"text\": \"World\", \"fontSize\": 40, \"_bounds\": [0, 0, 10, 10]}");
+
+    auto key = AplCoreTextMeasureCache::makeKey(first, 100, 1, 200, 0);
+    ASSERT_EQ(key, AplCoreTextMeasureCache::makeKey(second, 100, 1, 200, 0));
+    ASSERT_NE(key, AplCoreTextMeasureCache::makeKey(other, 100, 1, 200, 0));
+    ASSERT_NE(key, AplCoreTextMeasureCache::makeKey(first, 101, 1, 200, 0));
+    ASSERT_NE(key, AplCoreTextMeasureCache::makeKey(first, 100, 2, 200, 0));
+}
+
+TEST(AplCoreTextMeasureCacheTest, ParsesOptionalTextMetrics) {
+    AplCoreTextMeasureCache::Entry entry;
+
+    ASSERT_TRUE(AplCoreTextMeasureCache::parseEntry(parse("{\"width\": 100, \"height\": 40}"), entry));
+    ASSERT_FALSE(entry.hasBaseline);
+
+    ASSERT_TRUE(AplCoreTextMeasureCache::parseEntry(
+        parse("{\"width\": 100, \"height\": 80, \"baseline\": 32, \"lineCount\": 2, \"lastLineWidth\": 60}"),
+        entry));
+    ASSERT_TRUE(entry.hasBaseline);
+    ASSERT_EQ(32, entry.baseline);
+    ASSERT_EQ(2, entry.lineCount);
+    ASSERT_EQ(60, entry.lastLineWidth);
+
+    ASSERT_FALSE(AplCoreTextMeasureCache::parseEntry(parse("{\"width\": 100}"), entry));
+}
+
+TEST(AplCoreTextMeasureCacheTest, EvictsLeastRecentlyUsed) {
+    AplCoreTextMeasureCache cache(2);
+    AplCoreTextMeasureCache::Entry entry;
+
+    cache.put(1, {10, 10});
+    cache.put(2, {20, 20});
+    ASSERT_TRUE(cache.get(1, entry));
+    cache.put(3, {30, 30});
+
+    ASSERT_EQ(2u, cache.size());
+    ASSERT_FALSE(cache.get(2, entry));
+    ASSERT_TRUE(cache.get(1, entry));
+    ASSERT_EQ(10, entry.width);
+    ASSERT_TRUE(cache.get(3, entry));
+    ASSERT_EQ(30, entry.height);
+
+    cache.clear();
+    ASSERT_EQ(0u, cache.size());
+    ASSERT_FALSE(cache.get(1, entry));
+}
+
+}  // namespace test
+}  // namespace APLClient
@@ -0,0 +1,94 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "APLClient/AplCoreViewhostMessage.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace ::testing;
+
+namespace APLClient {
+namespace test {
+
+/// The spaces serialized messages start with
+static const std::string HEADROOM(AplCoreViewhostMessageArena::HEADROOM, ' ');
+
+static rapidjson::Value makePayload(rapidjson::MemoryPoolAllocator<>& alloc, int count) {
+    rapidjson::Value payload(rapidjson::kArrayType);
+    for (int i = 0; i < count; i++) {
+        payload.PushBack(rapidjson::Value(std::to_string(i).c_str(), alloc).Move(), alloc);
+    }
+    return payload;
+}
+
+TEST(AplCoreViewhostMessageArenaTest, SerializesLikeOwnedMessage) {
+    AplCoreViewhostMessageArena arena;
+
+    AplCoreViewhostMessage owned("dirty");
+    owned.setSequenceNumber(7).setPayload(makePayload(owned.alloc(), 10));
+    std::string expected = owned.get();
+
+    AplCoreViewhostMessage pooled("dirty", arena);
+    pooled.setSequenceNumber(7).setPayload(makePayload(pooled.alloc(), 10));
+    ASSERT_EQ(expected, pooled.get());
+}
+
+TEST(AplCoreViewhostMessageArenaTest, FallsBackWhileHeld) {
+    AplCoreViewhostMessageArena arena;
+
+    auto first = AplCoreViewhostMessage("event", arena);
+    {
+        AplCoreViewhostMessage second("event", arena);
+        ASSERT_EQ(HEADROOM + "{\"type\":\"event\"}", second.get());
+    }
+    ASSERT_FALSE(arena.acquire());
+    ASSERT_EQ(HEADROOM + "{\"type\":\"event\"}", first.get());
+}
+
+TEST(AplCoreViewhostMessageArenaTest, GrowsToFitMessages) {
+    AplCoreViewhostMessageArena arena(1024);
+    {
+        AplCoreViewhostMessage msg("dirty", arena);
+        msg.setPayload(makePayload(msg.alloc(), 1000));
+    }
+    auto grown = arena.capacity();
+    ASSERT_LT(1024u, grown);
+
+    {
+        AplCoreViewhostMessage msg("dirty", arena);
+        msg.setPayload(makePayload(msg.alloc(), 1000));
+    }
+    ASSERT_EQ(grown, arena.capacity());
+}
+
+TEST(AplCoreViewhostMessageArenaTest, TakesOutputWithoutCopying) {
+    AplCoreViewhostMessageArena arena;
+    AplCoreViewhostMessage msg("hierarchy", arena);
+    msg.setPayload(makePayload(msg.alloc(), 10000));
+
+    const auto& serialized = msg.get();
+    auto data = serialized.data();
+    auto size = serialized.size();
+    auto taken = msg.take();
+    ASSERT_EQ(data, taken.data());
+    ASSERT_EQ(size, taken.size());
+
+    // The arena keeps an output buffer for the next message
+    ASSERT_LE(size, arena.outputCapacity());
+}
+
+}  // namespace test
+}  // namespace APLClient
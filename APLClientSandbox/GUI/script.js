@@ -108,15 +108,16 @@ const handleMessage = (data) => {
             resetViewhost();
             break;
         case 'viewhost':
-            const payload = JSON.parse(data.payload);
+            // Large messages are handed over by the client and embedded as they are rather than as a string
+            const payload = typeof data.payload === 'string' ? JSON.parse(data.payload) : data.payload;
             if (payload.type === 'metric') {
                 const metric = payload.payload;
                 return console.log(formatMetricLog(new Date(), metric));
             }
-            client.onMessage(JSON.parse(data.payload));
+            client.onMessage(payload);
             break;
         case 'resourcerequest':
-            handleResourceRequest(data.payload);
+            handleResourceRequest(data.payload, data.id);
             break;
         default:
             console.error("Unknown message type");
@@ -138,12 +139,13 @@ const load = () => {
     document.getElementsByClassName('tab')[0].click();
 };
 
-const handleResourceRequest = (source) => {
+const handleResourceRequest = (source, id) => {
     console.log('retrieving resource', source);
     fetch(source).then((response) => {
         if (!response.ok) {
             socket.send({
                 type: 'resourceresponse',
+                id: id,
                 url: source,
                 payload: ''
             });
@@ -151,6 +153,7 @@ const handleResourceRequest = (source) => {
             response.text().then((data) => {
                 socket.send({
                     type: 'resourceresponse',
+                    id: id,
                     url: source,
                     payload: data
                 });
@@ -18,6 +18,7 @@
 
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <alexaext/alexaext.h>
 
 #include "APLClient/AplClientBinding.h"
@@ -26,6 +27,7 @@
 #include "APLClient/Extensions/AudioPlayer/AplAudioPlayerAlarmsExtension.h"
 #include "APLClient/Extensions/Backstack/AplBackstackExtension.h"
 #include "APLClient/Extensions/AttentionSystem/AplAttentionSystemExtension.h"
+#include "APLClient/AplCoreViewhostInboundMessage.h"
 #include "APLClient/AplOptionsInterface.h"
 #include "APLClientSandbox/Executor.h"
 #include "GUIManager.h"
@@ -51,6 +53,11 @@ public:
      */
     void updateTick();
 
+    /**
+     * Logs the queue depth and wait time statistics of each lane of the executor
+     */
+    void logExecutorMetrics();
+
     /**
      * Renders the given document
      * @param document
@@ -77,9 +84,9 @@ public:
 
     /**
      * Should be called when a message is received from the viewhost
-     * @param message the viewhost message
+     * @param message the parsed viewhost message
      */
-    void onMessage(const std::string& message);
+    void onMessage(const APLClient::AplCoreViewhostInboundMessage& message);
 
     /// @name AplBackstackExtensionObserverInterface Functions
     /// @{
@@ -158,14 +165,16 @@ public:
 
     /**
      * To be called when a resource has been retrieved
+     * @param id The id of the resource request
      * @param url The URL of the retrieved resource
      * @param payload The payload of the resource
      */
-    void provideResource(const std::string& url, const std::string& payload);
+    void provideResource(unsigned id, const std::string& url, const std::string& payload);
 
     /// @name AplOptionsInterface functions
     /// @{
     void sendMessage(const std::string& token, const std::string& payload) override;
+    void transferMessage(const std::string& token, std::string&& payload) override;
     void resetViewhost(const std::string& token) override;
     std::string downloadResource(const std::string& source) override;
     std::chrono::milliseconds getTimezoneOffset() override;
@@ -211,6 +220,13 @@ private:
     /// Private constructor
     AplClientBridge();
 
+    /**
+     * Submits a task which changes the state of the renderer, requesting an update once it has run
+     * @param task The task
+     * @param lane The priority lane to queue the task in
+     */
+    void submitRendererTask(std::function<void()> task, Executor::Lane lane = Executor::Lane::BACKGROUND);
+
     /// The GUI Manager
     std::weak_ptr<GUIManager> m_manager;
 
@@ -220,14 +236,22 @@ private:
     /// Pointer to the APL Client Renderer
     std::shared_ptr<APLClient::AplClientRenderer> m_aplClientRenderer;
 
-    /// Mutex to prevent more than one resource being downloaded simultaneously
+    /// A resource request awaiting its response
+    struct PendingResource {
+        /// The url requested
+        std::string url;
+        /// Resolved once the resource has been retrieved
+        std::promise<std::string> promise;
+    };
+
+    /// Mutex protecting the outstanding resource requests
     std::mutex m_downloadMutex;
 
-    /// Promise set when a resoure request it made, should be resolved once it has been retrieved
-    std::promise<std::string> m_resourcePromise;
+    /// The outstanding resource requests by id, any number may be in flight at once
+    std::unordered_map<unsigned, PendingResource> m_pendingResources;
 
-    /// The url from the outstanding resource request
-    std::string m_resourcePromiseUrl;
+    /// The id of the next resource request
+    unsigned m_nextResourceId = 0;
 
     /// The execution thread
     Executor m_executor;
@@ -16,19 +16,59 @@
 #ifndef APLCLIENTSANDBOX_INCLUDE_EXECUTOR_H_
 #define APLCLIENTSANDBOX_INCLUDE_EXECUTOR_H_
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <queue>
 #include <thread>
 #include <functional>
+#include <vector>
 
 /**
  * A simple executor used to run callable types asynchronously.
+ *
+ * Tasks are queued in priority lanes. The thread runs the oldest task of the highest priority lane which has any,
+ * unless a task of a lower lane has waited longer than that lane's starvation limit, in which case it runs first.
+ * Tasks of the same lane run in the order they were submitted.
  */
 class Executor {
 public:
+    /// The clock used for delayed tasks
+    using Clock = std::chrono::steady_clock;
+
+    /// The priority lanes, highest priority first
+    enum class Lane {
+        /// User input and replies to requests, which must not wait behind other work
+        INTERACTIVE = 0,
+        /// Frame updates
+        FRAME,
+        /// Everything else, such as rendering documents, extensions and telemetry
+        BACKGROUND,
+        /// The number of lanes
+        COUNT
+    };
+
+    /// Queue depth and wait time statistics of a lane
+    struct LaneMetrics {
+        /// The number of tasks currently queued
+        size_t depth = 0;
+        /// The highest number of tasks ever queued at once
+        size_t maxDepth = 0;
+        /// The number of tasks run
+        uint64_t tasksRun = 0;
+        /// The number of tasks run ahead of higher lanes by starvation protection
+        uint64_t tasksPromoted = 0;
+        /// The total time tasks waited in the queue
+        std::chrono::microseconds totalWait{0};
+        /// The longest time a task waited in the queue
+        std::chrono::microseconds maxWait{0};
+    };
+
     /**
      * Constructs an Executor.
      */
@@ -44,24 +84,98 @@ public:
      * on an Executor thread.
      *
      * @param task A callable type representing a task.
+     * @param lane The priority lane to queue the task in.
+     */
+    template <typename Task>
+    void submit(Task task, Lane lane = Lane::BACKGROUND);
+
+    /**
+     * Submits a callable type to be executed on an Executor thread once @c delay has passed. The thread is free to
+     * run other tasks in the meantime.
+     *
+     * @param delay The time to wait before running the task.
+     * @param task A callable type representing a task.
+     * @param lane The priority lane to queue the task in once it is due.
      */
     template <typename Task>
-    void submit(Task task);
+    void submitAfter(const std::chrono::milliseconds& delay, Task task, Lane lane = Lane::BACKGROUND);
+
+    /**
+     * Submits a callable type to be executed on an Executor thread once @c time is reached. Tasks due at the same
+     * time run in the order they were submitted.
+     *
+     * @param time The time at which to run the task.
+     * @param task A callable type representing a task.
+     * @param lane The priority lane to queue the task in once it is due.
+     */
+    template <typename Task>
+    void submitAt(const Clock::time_point& time, Task task, Lane lane = Lane::BACKGROUND);
 
     /// Clears the executor of outstanding tasks and refuses any additional tasks to be submitted.
     void shutdown();
 
+    /**
+     * @param lane The lane
+     * @return The queue depth and wait time statistics of the lane
+     */
+    LaneMetrics getLaneMetrics(Lane lane);
+
 private:
     // The main thread run loop
     void runner();
 
+    /// A task queued in a lane
+    struct QueuedTask {
+        /// The task
+        std::function<void()> task;
+        /// The time the task was queued
+        Clock::time_point queued;
+    };
+
     /// The queue type to use for holding tasks.
-    using Queue = std::deque<std::function<void()>>;
+    using Queue = std::deque<QueuedTask>;
+
+    /// A task waiting for its time to run
+    struct DelayedTask {
+        /// The time at which the task is due
+        Clock::time_point time;
+        /// The submission order, which breaks ties between tasks due at the same time
+        uint64_t order;
+        /// The task
+        std::function<void()> task;
+        /// The lane to queue the task in once it is due
+        Lane lane;
+    };
+
+    /// Orders the timer heap so that the earliest task is on top
+    struct DueLater {
+        bool operator()(const DelayedTask& lhs, const DelayedTask& rhs) const {
+            return lhs.time != rhs.time ? lhs.time > rhs.time : lhs.order > rhs.order;
+        }
+    };
+
+    /// Queues a task in a lane, must be called with @c m_queueMutex held
+    void enqueue(std::function<void()> task, Lane lane, const Clock::time_point& now);
+
+    /// Moves the delayed tasks due by @c now into their lanes, must be called with @c m_queueMutex held
+    void promoteDueTasks(const Clock::time_point& now);
+
+    /// @return The lane to run a task from next, or @c Lane::COUNT if all are empty. Requires @c m_queueMutex.
+    Lane nextLane(const Clock::time_point& now);
+
+    /// The queues of tasks, indexed by lane
+    std::array<Queue, static_cast<size_t>(Lane::COUNT)> m_queues;
+
+    /// The statistics of each lane, protected by @c m_queueMutex
+    std::array<LaneMetrics, static_cast<size_t>(Lane::COUNT)> m_metrics;
+
+    /// The heap of delayed tasks
+    std::priority_queue<DelayedTask, std::vector<DelayedTask>, DueLater> m_delayed;
 
-    /// The queue of tasks
-    Queue m_queue;
+    /// The number of delayed tasks submitted so far
+    uint64_t m_delayedCount;
 
-    /// A mutex to protect access to the tasks in m_queue.
+    /// A mutex to protect access to the tasks in m_queues.
     std::mutex m_queueMutex;
 
     /// A flag for whether or not the queue is expecting more tasks.
@@ -74,9 +188,22 @@ private:
     std::thread m_thread;
 };
 template <typename Task>
-void Executor::submit(Task task) {
+void Executor::submit(Task task, Lane lane) {
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    enqueue(std::move(task), lane, Clock::now());
+    lock.unlock();
+    m_delayedCondition.notify_all();
+}
+
+template <typename Task>
+void Executor::submitAfter(const std::chrono::milliseconds& delay, Task task, Lane lane) {
+    submitAt(Clock::now() + delay, std::move(task), lane);
+}
+
+template <typename Task>
+void Executor::submitAt(const Clock::time_point& time, Task task, Lane lane) {
     std::unique_lock<std::mutex> lock(m_queueMutex);
-    m_queue.push_back(std::move(task));
+    m_delayed.push({time, m_delayedCount++, std::function<void()>(std::move(task)), lane});
     lock.unlock();
     m_delayedCondition.notify_all();
 }
@@ -16,9 +16,13 @@
 #ifndef APLCLIENTSANDBOX_INCLUDE_GUIMANAGER_H_
 #define APLCLIENTSANDBOX_INCLUDE_GUIMANAGER_H_
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include "WebSocketServer.h"
 #include "AplClientBridge.h"
+#include "Executor.h"
 #include "Message.h"
 
 class AplClientBridge;
@@ -62,15 +66,40 @@ public:
      */
     void sendMessage(const std::string& payload);
 
+    /**
+     * Sends a message from the APL Client to the GUI, wrapped in a viewhost message
+     * @param payload The serialized APL message
+     */
+    void sendViewhostMessage(const std::string& payload);
+
+    /**
+     * Sends a message from the APL Client to the GUI, taking over its buffer. The message is embedded in the
+     * viewhost message as it is rather than escaped as a string, so that it is neither copied nor escaped.
+     * @param payload The serialized APL message
+     */
+    void transferViewhostMessage(std::string&& payload);
+
     /**
      * Should be called once an update loop has finished executing - will queue the next update
+     * @param nextUpdateTime The time the renderer next needs an update, or @c time_point::max() if it waits for input
+     */
+    void onUpdateComplete(const Executor::Clock::time_point& nextUpdateTime);
+
+    /**
+     * Requests an update as soon as the frame rate allows, as when the state of the renderer has changed
      */
-    void onUpdateComplete();
+    void requestUpdate();
 
 private:
     /// Private constructor
     GUIManager(std::shared_ptr<WebSocketServer> server);
 
+    /**
+     * Schedules an update, unless one is already scheduled at or before the given time
+     * @param time The time of the update, which is delayed to keep to the frame rate
+     */
+    void scheduleUpdate(Executor::Clock::time_point time);
+
     /// The WebSocketServer
     std::shared_ptr<WebSocketServer> m_server;
 
@@ -80,6 +109,18 @@ private:
     /// Indicates whether a websocket connection is currently open
     bool m_connectionOpen;
 
+    /// The mutex protecting the update schedule
+    std::mutex m_updateMutex;
+
+    /// The time of the scheduled update, @c time_point::max() if none is
+    Executor::Clock::time_point m_nextUpdate;
+
+    /// The time the last update was run
+    Executor::Clock::time_point m_lastUpdate;
+
+    /// Incremented whenever an update is scheduled, so that a superseded update does not run
+    uint64_t m_updateGeneration;
+
     /// The execution thread
     Executor m_executor;
 };
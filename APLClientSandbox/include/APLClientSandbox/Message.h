@@ -43,6 +43,9 @@ const char MSG_STATE_TAG[] = "state";
 /// The type json key in the message
 const char MSG_TYPE_TAG[] = "type";
 
+/// The request id json key in the message
+const char MSG_ID_TAG[] = "id";
+
 /**
  * All messages have the format:
  * { "type": STRING }
@@ -184,8 +187,9 @@ public:
 /// A message to request a specific resource
 class ResourceRequestMessage : public Message {
 public:
-    ResourceRequestMessage(const std::string& url) : Message(RESOURCE_REQUEST_MESSAGE_TYPE) {
+    ResourceRequestMessage(const std::string& url, unsigned id) : Message(RESOURCE_REQUEST_MESSAGE_TYPE) {
         setPayload(url);
+        addMember(MSG_ID_TAG, id);
     }
 };
 
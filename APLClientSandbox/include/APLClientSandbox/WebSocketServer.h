@@ -99,6 +99,13 @@ public:
 
     bool start();
     void writeMessage(const std::string& payload);
+
+    /**
+     * Writes a message, taking over its buffer rather than copying it into a frame.
+     *
+     * @param payload The message to write.
+     */
+    void writeMessage(std::string&& payload);
     void setMessageListener(std::shared_ptr<MessageListenerInterface> messageListener);
     void stop();
     bool isReady();
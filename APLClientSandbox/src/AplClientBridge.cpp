@@ -24,6 +24,7 @@
 #include "APLClientSandbox/AplMetricsStreamSink.h"
 
 #include <chrono>
+#include <unordered_set>
 
 using namespace APLClient::Extensions;
 using namespace APLClient::Telemetry;
@@ -31,6 +32,17 @@ using namespace APLClient::Telemetry;
 static const std::chrono::milliseconds RESOURCE_DOWNLOAD_TIMEOUT{3000};
 static const bool SANDBOX_USE_ALEXA_EXT = true;
 
+/// The viewhost messages carrying user input or awaiting a reply, which are handled ahead of other work. Every other
+/// viewhost message stays in order with the document rendering and command tasks.
+static const std::unordered_set<std::string> INTERACTIVE_MESSAGE_TYPES = {
+    "handlePointerEvent",
+    "handleKeyboard",
+    "updateCursorPosition",
+    "isCharacterValid",
+    "getFocusableAreas",
+    "getFocused"
+};
+
 std::shared_ptr<AplClientBridge> AplClientBridge::create() {
     std::shared_ptr<AplClientBridge> client(new AplClientBridge());
     client->m_client = std::make_shared<APLClient::AplClientBinding>(client);
@@ -124,24 +136,47 @@ void AplClientBridge::addAlexaExtExtensions(
 void AplClientBridge::updateTick() {
         m_executor.submit([this]() {
         m_aplClientRenderer->onUpdateTick();
+        auto nextTickTime = m_aplClientRenderer->getNextTickTime();
         // update audioPlayer
         if (audioPlayerPlaying && m_audioPlayerExtension) {
             int offset = getCurrentTime().count() - audioPlayerStartTime;
             m_audioPlayerExtension->updatePlaybackProgress(offset);
+            // The playback progress is reported every tick
+            nextTickTime = Executor::Clock::now();
         }
         if (auto manager = m_manager.lock()) {
-            manager->onUpdateComplete();
+            manager->onUpdateComplete(nextTickTime);
         } else {
             Logger::error("AplClientBridge::sendMessage", "Manager not set");
         }
-    });
+    }, Executor::Lane::FRAME);
+}
+
+void AplClientBridge::submitRendererTask(std::function<void()> task, Executor::Lane lane) {
+    m_executor.submit([this, task]() {
+        task();
+        if (auto manager = m_manager.lock()) {
+            manager->requestUpdate();
+        }
+    }, lane);
+}
+
+void AplClientBridge::logExecutorMetrics() {
+    static const char* LANE_NAMES[] = {"interactive", "frame", "background"};
+    for (size_t lane = 0; lane < static_cast<size_t>(Executor::Lane::COUNT); lane++) {
+        auto metrics = m_executor.getLaneMetrics(static_cast<Executor::Lane>(lane));
+        auto averageWait = metrics.tasksRun ? metrics.totalWait.count() / metrics.tasksRun : 0;
+        Logger::info("AplClientBridge::logExecutorMetrics", LANE_NAMES[lane], "tasks:", metrics.tasksRun,
+                     "promoted:", metrics.tasksPromoted, "depth:", metrics.depth, "maxDepth:", metrics.maxDepth,
+                     "averageWaitUs:", averageWait, "maxWaitUs:", metrics.maxWait.count());
+    }
 }
 
 void AplClientBridge::renderDocument(
     const std::string& document,
     const std::string& data,
     const std::string& supportedViewports) {
-    m_executor.submit([this, document, data, supportedViewports]() {
+    submitRendererTask([this, document, data, supportedViewports]() {
         // When rendering a new document, add the current active document state to backstack (if it should be cached)
         if (m_backstackExtension && m_backstackExtension->shouldCacheActiveDocument()) {
             if (auto documentState = m_aplClientRenderer->getActiveDocumentState()) {
@@ -163,7 +198,7 @@ void AplClientBridge::renderDocument(
 }
 
 void AplClientBridge::clearDocument() {
-    m_executor.submit([this]() {
+    submitRendererTask([this]() {
         m_aplClientRenderer->clearDocument();
         if (m_backstackExtension) {
             m_backstackExtension->reset();
@@ -172,16 +207,21 @@ void AplClientBridge::clearDocument() {
 }
 
 void AplClientBridge::executeCommands(const std::string& jsonPayload) {
-    m_executor.submit([this, jsonPayload]() { m_aplClientRenderer->executeCommands(jsonPayload, ""); });
+    submitRendererTask([this, jsonPayload]() { m_aplClientRenderer->executeCommands(jsonPayload, ""); });
 }
 
 void AplClientBridge::interruptCommandSequence() {
-    m_executor.submit([this]() { m_aplClientRenderer->interruptCommandSequence(); });
+    submitRendererTask([this]() { m_aplClientRenderer->interruptCommandSequence(); });
 }
 
-void AplClientBridge::onMessage(const std::string& message) {
+void AplClientBridge::onMessage(const APLClient::AplCoreViewhostInboundMessage& message) {
+    // Replies to requests of the renderer are routed by shouldHandleMessage itself
     if (m_aplClientRenderer->shouldHandleMessage(message)) {
-        m_executor.submit([this, message]() { m_aplClientRenderer->handleMessage(message); });
+        // User input must not wait behind document rendering, while messages such as build or configurationChange
+        // must not overtake the rendering tasks queued before them
+        auto lane = INTERACTIVE_MESSAGE_TYPES.count(message.getType()) ? Executor::Lane::INTERACTIVE
+                                                                       : Executor::Lane::BACKGROUND;
+        submitRendererTask([this, message]() { m_aplClientRenderer->handleMessage(message); }, lane);
     }
 }
 
@@ -193,14 +233,21 @@ bool AplClientBridge::handleBack() {
 }
 
 void AplClientBridge::sendMessage(const std::string& token, const std::string& payload) {
-    ViewhostMessage message(payload);
     if (auto manager = m_manager.lock()) {
-        manager->sendMessage(message);
+        manager->sendViewhostMessage(payload);
     } else {
         Logger::error("AplClientBridge::sendMessage", "Manager not set");
     }
 }
 
+void AplClientBridge::transferMessage(const std::string& token, std::string&& payload) {
+    if (auto manager = m_manager.lock()) {
+        manager->transferViewhostMessage(std::move(payload));
+    } else {
+        Logger::error("AplClientBridge::transferMessage", "Manager not set");
+    }
+}
+
 void AplClientBridge::resetViewhost(const std::string& token) {
     Logger::debug("AplClientBridge::resetViewhost");
     ResetMessage message;
@@ -213,24 +260,32 @@ void AplClientBridge::resetViewhost(const std::string& token) {
 
 std::string AplClientBridge::downloadResource(const std::string& source) {
     Logger::debug("AplClientBridge::downloadResource", source);
-    ResourceRequestMessage message(source);
-    if (auto manager = m_manager.lock()) {
-        std::lock_guard<std::mutex> mtx(m_downloadMutex);
-        m_resourcePromiseUrl = source;
-        m_resourcePromise = std::promise<std::string>();
-        manager->sendMessage(message);
-        auto future = m_resourcePromise.get_future();
-        auto status = future.wait_for(RESOURCE_DOWNLOAD_TIMEOUT);
-        if (status != std::future_status::ready) {
-            Logger::error("AplClientBridge::downloadResource", "Did not receive reply for resource request");
-            return "";
-        } else {
-            return future.get();
-        }
-    } else {
+    auto manager = m_manager.lock();
+    if (!manager) {
         Logger::error("AplClientBridge::downloadResource", "Manager not set");
         return "";
     }
+
+    unsigned id;
+    std::future<std::string> future;
+    {
+        std::lock_guard<std::mutex> mtx(m_downloadMutex);
+        id = m_nextResourceId++;
+        auto& pending = m_pendingResources[id];
+        pending.url = source;
+        future = pending.promise.get_future();
+    }
+
+    ResourceRequestMessage message(source, id);
+    manager->sendMessage(message);
+    auto status = future.wait_for(RESOURCE_DOWNLOAD_TIMEOUT);
+    if (status != std::future_status::ready) {
+        Logger::error("AplClientBridge::downloadResource", "Did not receive reply for resource request");
+        std::lock_guard<std::mutex> mtx(m_downloadMutex);
+        m_pendingResources.erase(id);
+        return "";
+    }
+    return future.get();
 }
 
 std::chrono::milliseconds AplClientBridge::getTimezoneOffset() {
@@ -301,7 +356,7 @@ void AplClientBridge::onExtensionEvent(
     std::shared_ptr<AplCoreExtensionEventCallbackResultInterface> resultCallback) {
     Logger::info("AplClientBridge::onExtensionEvent");
 
-    m_executor.submit([this, uri, name, source, params, event, resultCallback] {
+    submitRendererTask([this, uri, name, source, params, event, resultCallback] {
         m_aplClientRenderer->onExtensionEvent(uri, name, source, params, event, resultCallback);
     });
 }
@@ -332,11 +387,16 @@ void AplClientBridge::setGUIManager(std::shared_ptr<GUIManager> manager) {
     m_manager = std::move(manager);
 }
 
-void AplClientBridge::provideResource(const std::string& url, const std::string& payload) {
-    if (url != m_resourcePromiseUrl) {
+void AplClientBridge::provideResource(unsigned id, const std::string& url, const std::string& payload) {
+    std::lock_guard<std::mutex> mtx(m_downloadMutex);
+    auto it = m_pendingResources.find(id);
+    if (it == m_pendingResources.end()) {
+        Logger::warn("AplClientBridge::provideResource", "Received resource for unknown or expired request");
+    } else if (url != it->second.url) {
         Logger::warn("AplClientBridge::provideResource", "Received resource for different url than expected");
     } else {
-        m_resourcePromise.set_value(payload);
+        it->second.promise.set_value(payload);
+        m_pendingResources.erase(it);
     }
 }
 
@@ -345,7 +405,7 @@ int AplClientBridge::getMaxNumberOfConcurrentDownloads() {
 }
 
 void AplClientBridge::onRestoreDocumentState(std::shared_ptr<APLClient::AplDocumentState> documentState) {
-    m_executor.submit([this, documentState]() { m_aplClientRenderer->restoreDocumentState(documentState); });
+    submitRendererTask([this, documentState]() { m_aplClientRenderer->restoreDocumentState(documentState); });
 }
 
 void AplClientBridge::onAudioPlayerPlay() {
@@ -451,5 +511,5 @@ void AplClientBridge::updateAttentionSystemState(const std::string& state) {
 
 void AplClientBridge::processDataSourceUpdate(const std::string& updateIndexListData, const std::string& dynamicDataSourceType) {
     Logger::info("AplClientBridge::processDataSourceUpdate", updateIndexListData, dynamicDataSourceType);
-    m_executor.submit([this, updateIndexListData, dynamicDataSourceType]() { m_aplClientRenderer->dataSourceUpdate(dynamicDataSourceType, updateIndexListData, ""); });
+    submitRendererTask([this, updateIndexListData, dynamicDataSourceType]() { m_aplClientRenderer->dataSourceUpdate(dynamicDataSourceType, updateIndexListData, ""); });
 }
\ No newline at end of file
@@ -13,19 +13,34 @@
  * permissions and limitations under the License.
  */
 
+#include <algorithm>
+
 #include "APLClientSandbox/Executor.h"
 
+/// How long a task of each lane may wait before it runs ahead of higher lanes, indexed by lane
+static const std::chrono::milliseconds STARVATION_LIMITS[] = {
+    std::chrono::milliseconds(0),      // INTERACTIVE, unused as nothing runs ahead of it
+    std::chrono::milliseconds(50),     // FRAME
+    std::chrono::milliseconds(200),    // BACKGROUND
+};
+
 Executor::~Executor() {
     shutdown();
 }
 
-Executor::Executor() : m_shutdown{false} {
+Executor::Executor() : m_delayedCount{0}, m_shutdown{false} {
     m_thread = std::thread(&Executor::runner, this);
 }
 
 void Executor::shutdown() {
     std::unique_lock<std::mutex> lock{m_queueMutex};
-    m_queue.clear();
+    for (auto& queue : m_queues) {
+        queue.clear();
+    }
+    for (auto& metrics : m_metrics) {
+        metrics.depth = 0;
+    }
+    m_delayed = decltype(m_delayed)();
     m_shutdown = true;
     lock.unlock();
     m_delayedCondition.notify_all();
@@ -38,13 +53,41 @@ void Executor::runner() {
     std::unique_lock<std::mutex> lock(m_queueMutex);
 
     do {
-        // Wait until we have data or a quit signal
-        m_delayedCondition.wait(lock, [this] { return (!m_queue.empty() || m_shutdown); });
+        auto now = Clock::now();
+        promoteDueTasks(now);
+        auto lane = nextLane(now);
+
+        // Wait until we have data, a delayed task is due or a quit signal
+        if (lane == Lane::COUNT && !m_shutdown) {
+            if (m_delayed.empty()) {
+                m_delayedCondition.wait(lock);
+            } else {
+                // Copy the due time as the heap may change while the lock is released
+                auto due = m_delayed.top().time;
+                m_delayedCondition.wait_until(lock, due);
+            }
+            continue;
+        }
 
-        // after wait, we own the lock
-        if (!m_shutdown && !m_queue.empty()) {
-            auto op = std::move(m_queue.front());
-            m_queue.pop_front();
+        // we own the lock
+        if (!m_shutdown && lane != Lane::COUNT) {
+            auto index = static_cast<size_t>(lane);
+            auto& queue = m_queues[index];
+            auto op = std::move(queue.front().task);
+            auto wait = std::chrono::duration_cast<std::chrono::microseconds>(now - queue.front().queued);
+            queue.pop_front();
+
+            auto& metrics = m_metrics[index];
+            metrics.depth = queue.size();
+            metrics.tasksRun++;
+            metrics.totalWait += wait;
+            metrics.maxWait = std::max(metrics.maxWait, wait);
+            for (size_t higher = 0; higher < index; higher++) {
+                if (!m_queues[higher].empty()) {
+                    metrics.tasksPromoted++;
+                    break;
+                }
+            }
 
             // unlock now that we're done messing with the queue
             lock.unlock();
@@ -54,4 +97,42 @@ void Executor::runner() {
             lock.lock();
         }
     } while (!m_shutdown);
-}
\ No newline at end of file
+}
+
+Executor::LaneMetrics Executor::getLaneMetrics(Lane lane) {
+    std::lock_guard<std::mutex> lock{m_queueMutex};
+    return m_metrics[static_cast<size_t>(lane)];
+}
+
+void Executor::enqueue(std::function<void()> task, Lane lane, const Clock::time_point& now) {
+    auto index = static_cast<size_t>(lane);
+    m_queues[index].push_back({std::move(task), now});
+    auto& metrics = m_metrics[index];
+    metrics.depth = m_queues[index].size();
+    metrics.maxDepth = std::max(metrics.maxDepth, metrics.depth);
+}
+
+void Executor::promoteDueTasks(const Clock::time_point& now) {
+    while (!m_delayed.empty() && m_delayed.top().time <= now) {
+        // The heap only exposes a const top, the task is copied out before being popped
+        enqueue(m_delayed.top().task, m_delayed.top().lane, m_delayed.top().time);
+        m_delayed.pop();
+    }
+}
+
+Executor::Lane Executor::nextLane(const Clock::time_point& now) {
+    // A starved task runs first, the lowest lane having the longest limit is checked first
+    for (size_t index = m_queues.size(); index-- > 1;) {
+        auto& queue = m_queues[index];
+        if (!queue.empty() && now - queue.front().queued >= STARVATION_LIMITS[index]) {
+            return static_cast<Lane>(index);
+        }
+    }
+
+    for (size_t index = 0; index < m_queues.size(); index++) {
+        if (!m_queues[index].empty()) {
+            return static_cast<Lane>(index);
+        }
+    }
+    return Lane::COUNT;
+}
@@ -13,11 +13,16 @@
  * permissions and limitations under the License.
  */
 
+#include <algorithm>
+
 #include <rapidjson/document.h>
 #include <APLClientSandbox/Logger.h>
+#include "APLClient/AplCoreViewhostMessageArena.h"
 #include "APLClientSandbox/GUIManager.h"
 
 static const std::chrono::milliseconds UPDATE_TICK_INTERVAL_MS{1000 / 60};  // 60 updates per second
+/// The longest time between updates of an idle renderer, which covers state changed by extensions on other threads
+static const std::chrono::milliseconds MAX_IDLE_UPDATE_INTERVAL_MS{1000};
 
 std::shared_ptr<GUIManager> GUIManager::create(std::shared_ptr<WebSocketServer> server) {
     std::shared_ptr<GUIManager> guiManager(new GUIManager(server));
@@ -30,7 +35,9 @@ std::shared_ptr<GUIManager> GUIManager::create(std::shared_ptr<WebSocketServer>
 GUIManager::GUIManager(std::shared_ptr<WebSocketServer> server) :
         m_server{std::move(server)},
         m_client{AplClientBridge::create()},
-        m_connectionOpen{false} {
+        m_connectionOpen{false},
+        m_nextUpdate{Executor::Clock::time_point::max()},
+        m_updateGeneration{0} {
 }
 
 void GUIManager::onMessage(const std::string& payload) {
@@ -40,7 +47,9 @@ void GUIManager::onMessage(const std::string& payload) {
         return;
     }
 
-    rapidjson::Document doc;
+    // The document is shared so that an "apl" message can be handed to the client without re-serializing it
+    auto parsed = std::make_shared<rapidjson::Document>();
+    auto& doc = *parsed;
     if (doc.Parse(payload.c_str()).HasParseError()) {
         Logger::error("GUIManager::onMessage", "Failed to parse JSON");
         return;
@@ -88,11 +97,7 @@ void GUIManager::onMessage(const std::string& payload) {
             return;
         }
 
-        rapidjson::StringBuffer sb;
-        rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-        doc["payload"].Accept(writer);
-
-        m_client->onMessage(sb.GetString());
+        m_client->onMessage(APLClient::AplCoreViewhostInboundMessage(parsed, "payload"));
     } else if (type == "resourceresponse") {
         if (!doc.HasMember("url") || !doc["url"].IsString()) {
             Logger::error("GUIManager::onMessage", "resourceresponse: Missing url from JSON payload");
@@ -104,10 +109,15 @@ void GUIManager::onMessage(const std::string& payload) {
             return;
         }
 
+        if (!doc.HasMember("id") || !doc["id"].IsUint()) {
+            Logger::error("GUIManager::onMessage", "resourceresponse: Missing id from JSON payload");
+            return;
+        }
+
         const std::string url = doc["url"].GetString();
         const std::string payload = doc["payload"].GetString();
 
-        m_client->provideResource(url, payload);
+        m_client->provideResource(doc["id"].GetUint(), url, payload);
     } else if (type == "updateAttentionSystemState") {
         const std::string payload = doc["payload"].GetString();
 
@@ -118,18 +128,23 @@ void GUIManager::onMessage(const std::string& payload) {
         m_client->processDataSourceUpdate(updateIndexListData, dynamicDataSourceType);
     } else {
         Logger::error("GUIManager::onMessage", "Unknown message type", type);
+        return;
     }
+
+    // Any message may change the state of the renderer, which then needs an update before its next scheduled one
+    requestUpdate();
 }
 
 void GUIManager::onConnectionOpened() {
     m_connectionOpen = true;
     // Schedule the next update
-    onUpdateComplete();
+    requestUpdate();
 }
 
 void GUIManager::onConnectionClosed() {
     m_connectionOpen = false;
     m_client->clearDocument();
+    m_client->logExecutorMetrics();
 }
 
 void GUIManager::sendMessage(const Message& message) {
@@ -144,12 +159,86 @@ void GUIManager::sendMessage(const std::string& payload) {
     }
 }
 
-void GUIManager::onUpdateComplete() {
-    // schedule the next update
-    if (m_connectionOpen) {
-        m_executor.submit([this]() {
-            std::this_thread::sleep_for(UPDATE_TICK_INTERVAL_MS);
-            m_client->updateTick();
-        });
+void GUIManager::sendViewhostMessage(const std::string& payload) {
+    if (!m_connectionOpen) {
+        Logger::warn("GUIManager::sendViewhostMessage", "Attempted to send message without open connection");
+        return;
+    }
+
+    // Write the envelope straight into the buffer handed to the server, the payload is escaped as a json string
+    std::string envelope;
+    envelope.reserve(payload.size() + payload.size() / 8 + 64);
+    APLClient::AplCoreStringOutputStream stream(envelope);
+    APLClient::AplCoreViewhostMessageArena::Writer writer(stream);
+    writer.StartObject();
+    writer.Key(MSG_TYPE_TAG);
+    writer.String(VIEWHOST_MESSAGE_TYPE.c_str(), static_cast<rapidjson::SizeType>(VIEWHOST_MESSAGE_TYPE.size()));
+    writer.Key(MSG_PAYLOAD_TAG);
+    writer.String(payload.c_str(), static_cast<rapidjson::SizeType>(payload.size()));
+    writer.EndObject();
+
+    m_server->writeMessage(std::move(envelope));
+}
+
+void GUIManager::transferViewhostMessage(std::string&& payload) {
+    if (!m_connectionOpen) {
+        Logger::warn("GUIManager::transferViewhostMessage", "Attempted to send message without open connection");
+        return;
+    }
+
+    // Wrap the envelope around the message in its own buffer, writing its start over the headroom the message
+    // starts with
+    std::string prefix;
+    prefix.append("{\"").append(MSG_TYPE_TAG).append("\":\"").append(VIEWHOST_MESSAGE_TYPE);
+    prefix.append("\",\"").append(MSG_PAYLOAD_TAG).append("\":");
+    if (payload.size() >= prefix.size() && payload.find_first_not_of(' ') >= prefix.size()) {
+        std::copy(prefix.begin(), prefix.end(), payload.begin());
+    } else {
+        payload.insert(0, prefix);
+    }
+    payload.append(1, '}');
+
+    m_server->writeMessage(std::move(payload));
+}
+
+void GUIManager::onUpdateComplete(const Executor::Clock::time_point& nextUpdateTime) {
+    // schedule the next update, an idle renderer is woken by requestUpdate
+    auto now = Executor::Clock::now();
+    if (nextUpdateTime - now > MAX_IDLE_UPDATE_INTERVAL_MS) {
+        scheduleUpdate(now + MAX_IDLE_UPDATE_INTERVAL_MS);
+    } else {
+        scheduleUpdate(nextUpdateTime);
+    }
+}
+
+void GUIManager::requestUpdate() {
+    scheduleUpdate(Executor::Clock::now());
+}
+
+void GUIManager::scheduleUpdate(Executor::Clock::time_point time) {
+    std::lock_guard<std::mutex> lock{m_updateMutex};
+    if (!m_connectionOpen) {
+        return;
+    }
+    if (m_lastUpdate != Executor::Clock::time_point() && time < m_lastUpdate + UPDATE_TICK_INTERVAL_MS) {
+        time = m_lastUpdate + UPDATE_TICK_INTERVAL_MS;
     }
+    if (time >= m_nextUpdate) {
+        return;
+    }
+
+    m_nextUpdate = time;
+    auto generation = ++m_updateGeneration;
+    m_executor.submitAt(time, [this, generation]() {
+        {
+            std::lock_guard<std::mutex> lock{m_updateMutex};
+            if (generation != m_updateGeneration) {
+                // An earlier update was scheduled since
+                return;
+            }
+            m_nextUpdate = Executor::Clock::time_point::max();
+            m_lastUpdate = Executor::Clock::now();
+        }
+        m_client->updateTick();
+    }, Executor::Lane::FRAME);
 }
\ No newline at end of file
@@ -113,6 +113,18 @@ void WebSocketServer::writeMessage(const std::string& payload) {
     }
 }
 
+void WebSocketServer::writeMessage(std::string&& payload) {
+    websocketpp::lib::error_code errorCode;
+
+    // The message adopts the buffer, only framing copies it to the socket
+    auto message = std::make_shared<WebSocketConfig::message_type>(nullptr, websocketpp::frame::opcode::text, 0);
+    message->get_raw_payload() = std::move(payload);
+    m_webSocketServer.send(m_connection, message, errorCode);
+    if (errorCode) {
+        logError("server::send", errorCode);
+    }
+}
+
 void WebSocketServer::onConnectionOpen(connection_hdl connectionHdl) {
     m_connection = connectionHdl;
 